@@ -0,0 +1,203 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of workers, each with its own task deque: a worker pushes and
+// pops at the back of its own deque (LIFO, cache-warm), idle workers steal
+// from the front of the others' (FIFO, the oldest and usually biggest work)
+class WorkStealingPool
+{
+public:
+  explicit WorkStealingPool(unsigned threads = std::thread::hardware_concurrency())
+  {
+    threads = std::max(1u, threads);
+    for (unsigned i = 0; i < threads; ++i)
+      queues.emplace_back(new Queue);
+    for (unsigned i = 0; i < threads; ++i)
+      workers.emplace_back([this, i] { work(i); });
+  }
+
+  ~WorkStealingPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock{sleep_mutex};
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto& w : workers)
+      w.join();
+  }
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+  // from a worker the task goes to that worker's deque, otherwise to the
+  // deques in round-robin order
+  void submit(std::function<void()> task)
+  {
+    auto index = current().pool == this
+      ? current().index
+      : next_queue++ % queues.size();
+    {
+      std::lock_guard<std::mutex> lock{queues[index]->mutex};
+      queues[index]->tasks.push_back(std::move(task));
+    }
+    pending.fetch_add(1, std::memory_order_release);
+    // take the lock so a worker between its check and its wait can't miss this
+    { std::lock_guard<std::mutex> lock{sleep_mutex}; }
+    wake.notify_one();
+  }
+
+  // runs one queued task on the calling thread, if there is any; lets a
+  // thread that waits for results help instead of blocking a worker
+  bool try_run_one()
+  {
+    std::function<void()> task;
+    auto self = current().pool == this ? current().index : 0;
+    if (!take(self, task))
+      return false;
+    task();
+    return true;
+  }
+
+private:
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  struct Worker
+  {
+    const WorkStealingPool* pool = nullptr;
+    size_t index = 0;
+  };
+
+  static Worker& current()
+  {
+    thread_local Worker worker;
+    return worker;
+  }
+
+  // own deque from the back, then the others from the front
+  bool take(size_t self, std::function<void()>& task)
+  {
+    if (pending.load(std::memory_order_acquire) == 0)
+      return false;
+    for (size_t i = 0; i < queues.size(); ++i)
+    {
+      auto& q = *queues[(self + i) % queues.size()];
+      std::lock_guard<std::mutex> lock{q.mutex};
+      if (q.tasks.empty())
+        continue;
+      if (i == 0)
+      {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+      }
+      else
+      {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+      }
+      pending.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+    return false;
+  }
+
+  void work(size_t index)
+  {
+    current().pool = this;
+    current().index = index;
+
+    std::function<void()> task;
+    while (true)
+    {
+      if (take(index, task))
+      {
+        task();
+        task = nullptr;
+        continue;
+      }
+      std::unique_lock<std::mutex> lock{sleep_mutex};
+      wake.wait(lock, [this] {
+        return stopping || pending.load(std::memory_order_acquire) > 0;
+      });
+      if (stopping && pending.load(std::memory_order_acquire) == 0)
+        return;
+    }
+  }
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+  std::atomic<size_t> pending{0};
+  std::atomic<size_t> next_queue{0};
+  std::mutex sleep_mutex;
+  std::condition_variable wake;
+  bool stopping = false;
+};
+
+// fork/join helper: run() forks tasks onto the pool, wait() blocks until
+// all of them are done, executing queued tasks meanwhile so that nested
+// groups on worker threads never deadlock the pool. if tasks throw, the
+// first exception is rethrown from wait(); the others are dropped
+class TaskGroup
+{
+public:
+  explicit TaskGroup(WorkStealingPool& pool) : pool{pool} {}
+  ~TaskGroup() { join(); }
+
+  template <typename F> void run(F&& f)
+  {
+    outstanding.fetch_add(1, std::memory_order_relaxed);
+    pool.submit([this, f = std::forward<F>(f)]() mutable {
+      try
+      {
+        f();
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock{error_mutex};
+        if (!error)
+          error = std::current_exception();
+      }
+      outstanding.fetch_sub(1, std::memory_order_release);
+    });
+  }
+
+  void wait()
+  {
+    join();
+    if (error)
+    {
+      auto e = error;
+      error = nullptr;
+      std::rethrow_exception(e);
+    }
+  }
+
+private:
+  void join()
+  {
+    while (outstanding.load(std::memory_order_acquire) != 0)
+      if (!pool.try_run_one())
+        std::this_thread::yield();
+  }
+
+  WorkStealingPool& pool;
+  std::atomic<size_t> outstanding{0};
+  std::mutex error_mutex;
+  std::exception_ptr error;
+};
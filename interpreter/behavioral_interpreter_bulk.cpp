@@ -0,0 +1,219 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <memory>
+#include <atomic>
+#include <stdexcept>
+using namespace std;
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "behavioral_interpreter_bulk.h"
+#include "behavioral_interpreter_bytecode.h"
+
+namespace
+{
+  // read-only mapping of a whole file, unmapped on scope exit
+  struct MappedFile
+  {
+    const char* data = nullptr;
+    size_t size = 0;
+
+    explicit MappedFile(const string& path)
+    {
+      auto fd = open(path.c_str(), O_RDONLY);
+      if (fd < 0)
+        throw runtime_error("cannot open " + path);
+      struct stat st;
+      if (fstat(fd, &st) == 0 && st.st_size > 0)
+      {
+        size = static_cast<size_t>(st.st_size);
+        auto p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+          close(fd);
+          throw runtime_error("cannot map " + path);
+        }
+        data = static_cast<const char*>(p);
+        madvise(p, size, MADV_SEQUENTIAL);
+      }
+      close(fd);
+    }
+
+    ~MappedFile()
+    {
+      if (data) munmap(const_cast<char*>(data), size);
+    }
+  };
+
+  struct Chunk
+  {
+    const char *first, *last;
+    string output;
+    size_t expressions = 0, errors = 0;
+    bool done = false; // guarded by the writer's mutex
+  };
+
+  void evaluate_chunk(Chunk& chunk, const int* variables)
+  {
+    thread_local ExpressionArena arena;
+    thread_local PrattParser parser;
+    thread_local ExpressionVM vm;
+
+    chunk.output.reserve((chunk.last - chunk.first) / 2);
+    for (auto line = chunk.first; line < chunk.last; )
+    {
+      auto eol = static_cast<const char*>(memchr(line, '\n', chunk.last - line));
+      if (!eol) eol = chunk.last;
+
+      arena.reset();
+      try
+      {
+        // compiled rather than tree-walked: deeply nested lines can't overflow the stack
+        chunk.output += to_string(vm.run(compile(parser.parse(line, eol, arena)), variables));
+      }
+      catch (const invalid_argument&)
+      {
+        chunk.output += "error";
+        ++chunk.errors;
+      }
+      chunk.output += '\n';
+      ++chunk.expressions;
+      line = eol + 1;
+    }
+  }
+}
+
+BulkReport evaluate_file(const string& input_path, const string& output_path,
+  const int* variables, WorkStealingPool& pool, size_t chunk_bytes)
+{
+  auto start = chrono::steady_clock::now();
+  MappedFile input{ input_path };
+  unique_ptr<FILE, int (*)(FILE*)> out{ fopen(output_path.c_str(), "wb"), fclose };
+  if (!out)
+    throw runtime_error("cannot open " + output_path);
+
+  // cut at the first newline after every chunk_bytes
+  vector<Chunk> chunks;
+  for (auto p = input.data, end = input.data + input.size; p < end; )
+  {
+    auto cut = p + min(chunk_bytes, static_cast<size_t>(end - p));
+    auto nl = cut < end ? static_cast<const char*>(memchr(cut, '\n', end - cut)) : nullptr;
+    auto last = nl ? nl + 1 : end;
+    chunks.push_back(Chunk{ p, last });
+    p = last;
+  }
+
+  // in-order writer: whoever finishes the oldest outstanding chunk flushes
+  // it together with any finished chunks right behind it
+  mutex writer;
+  size_t next_to_write = 0;
+  atomic<size_t> written{ 0 }; // next_to_write, for the submitting thread
+  bool write_failed = false;
+  auto finish = [&](Chunk& chunk) {
+    lock_guard<mutex> lock{ writer };
+    chunk.done = true;
+    while (next_to_write < chunks.size() && chunks[next_to_write].done)
+    {
+      auto& c = chunks[next_to_write++];
+      if (!write_failed && fwrite(c.output.data(), 1, c.output.size(), out.get()) != c.output.size())
+        write_failed = true;
+      string{}.swap(c.output);
+    }
+    written.store(next_to_write, memory_order_release);
+  };
+
+  {
+    // at most `window` chunks are submitted but not yet written, so only
+    // that many outputs are ever held in memory
+    const size_t window = 4 * pool.size();
+    atomic<bool> failed{ false };
+    TaskGroup group{ pool };
+    for (size_t i = 0; i < chunks.size() && !failed.load(memory_order_relaxed); ++i)
+    {
+      while (i - written.load(memory_order_acquire) >= window && !failed.load(memory_order_relaxed))
+        if (!pool.try_run_one())
+          this_thread::yield();
+      auto& chunk = chunks[i];
+      group.run([&chunk, &finish, &failed, variables] {
+        try
+        {
+          evaluate_chunk(chunk, variables);
+        }
+        catch (...)
+        {
+          // still finish the chunk so the chunks behind it get written and
+          // the window keeps moving; wait() rethrows the error
+          failed.store(true, memory_order_relaxed);
+          chunk.output.clear();
+          finish(chunk);
+          throw;
+        }
+        finish(chunk);
+      });
+    }
+    group.wait();
+  }
+  if (fclose(out.release()) != 0 || write_failed)
+    throw runtime_error("cannot write " + output_path);
+
+  BulkReport report;
+  for (auto& c : chunks)
+  {
+    report.expressions += c.expressions;
+    report.errors += c.errors;
+  }
+  report.bytes = input.size;
+  report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  return report;
+}
+
+// usage: main_interpreter_bulk(argc, argv) with argv[1] = input and optionally
+// argv[2] = output; without arguments it generates a sample input file first
+int main_interpreter_bulk(int argc, char* argv[])
+{
+  string input = argc > 1 ? argv[1] : "bulk_input.txt";
+  string output = argc > 2 ? argv[2] : "bulk_output.txt";
+
+  if (argc <= 1)
+  {
+    mt19937 rng{ 7 };
+    uniform_int_distribution<int> number(0, 999), op(0, 2), length(2, 8);
+    ofstream file{ input };
+    for (int line = 0; line < 5000000; ++line)
+    {
+      auto n = length(rng);
+      for (int i = 0; i < n; ++i)
+      {
+        if (i) file << "+-*"[op(rng)];
+        if (i % 3 == 1) file << "(x-" << number(rng) << ")";
+        else file << number(rng);
+      }
+      file << '\n';
+    }
+  }
+
+  int variables[variable_count] = {};
+  variables['x' - 'a'] = 42;
+
+  auto cores = max(1u, thread::hardware_concurrency());
+  for (unsigned threads = 1; ; threads = min(threads * 2, cores))
+  {
+    WorkStealingPool pool{ threads };
+    auto report = evaluate_file(input, output, variables, pool);
+    cout << threads << " threads: " << report.expressions << " expressions ("
+      << report.errors << " errors) in " << report.seconds << " s, "
+      << report.expressions_per_second() / 1e6 << " M expr/s, "
+      << report.megabytes_per_second() << " MB/s\n";
+    if (threads == cores) break;
+  }
+  return 0;
+}
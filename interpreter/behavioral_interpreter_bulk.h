@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+#include "../common/work_stealing_pool.h"
+#include "behavioral_interpreter_pratt.h"
+
+struct BulkReport
+{
+  size_t expressions = 0;
+  size_t errors = 0; // lines that failed to parse; written out as "error"
+  size_t bytes = 0;  // input size
+  double seconds = 0;
+
+  double expressions_per_second() const { return seconds > 0 ? expressions / seconds : 0; }
+  double megabytes_per_second() const { return seconds > 0 ? bytes / seconds / 1e6 : 0; }
+};
+
+// evaluates every line of `input_path` (one expression per line) and writes
+// one result per line to `output_path`, in input order
+//
+// the input is memory-mapped and cut into line-aligned chunks of about
+// `chunk_bytes`; each chunk is lexed, parsed and evaluated as one task on
+// `pool`, and finished chunks are flushed as soon as every chunk before
+// them is done. only a few chunks per worker are in flight at a time, so
+// pending output stays bounded. throws runtime_error if a file can't be
+// opened or the output can't be written
+BulkReport evaluate_file(const std::string& input_path, const std::string& output_path,
+  const int* variables, WorkStealingPool& pool, size_t chunk_bytes = 1 << 20);
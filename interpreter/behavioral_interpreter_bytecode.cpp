@@ -0,0 +1,185 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+using namespace std;
+
+#include "behavioral_interpreter_bytecode.h"
+
+Program compile(const AstNode* root, bool dag)
+{
+  Program result;
+  auto is_leaf = [](const AstNode* n) {
+    return n->type == AstNode::integer || n->type == AstNode::variable;
+  };
+
+  // count parents of interior nodes; only a DAG has counts above one
+  unordered_map<const AstNode*, int> uses;
+  vector<const AstNode*> pending;
+  if (dag) pending.push_back(root);
+  while (!pending.empty())
+  {
+    auto n = pending.back();
+    pending.pop_back();
+    if (is_leaf(n) || ++uses[n] > 1)
+      continue;
+    pending.push_back(n->lhs);
+    if (n->rhs) pending.push_back(n->rhs);
+  }
+  unordered_map<const AstNode*, int> temp_of;
+
+  struct Frame
+  {
+    const AstNode* node;
+    bool expanded;
+  };
+  vector<Frame> todo{ { root, false } };
+  size_t depth = 0;
+
+  auto emit = [&](Instruction::OpCode op, int operand, int stack_effect) {
+    result.code.push_back(Instruction{ op, operand });
+    depth += stack_effect;
+    result.max_stack = max(result.max_stack, depth);
+  };
+
+  while (!todo.empty())
+  {
+    auto frame = todo.back();
+    todo.pop_back();
+    auto n = frame.node;
+
+    bool shared = dag && !is_leaf(n) && uses[n] > 1;
+    if (shared && !frame.expanded)
+    {
+      auto temp = temp_of.find(n);
+      if (temp != temp_of.end())
+      {
+        emit(Instruction::load_temp, temp->second, 1);
+        continue;
+      }
+    }
+
+    switch (n->type)
+    {
+    case AstNode::integer:
+      emit(Instruction::push_const, n->value, 1);
+      break;
+    case AstNode::variable:
+      emit(Instruction::load_var, n->value, 1);
+      break;
+    case AstNode::negation:
+      if (frame.expanded)
+        emit(Instruction::negate, 0, 0);
+      else
+      {
+        todo.push_back({ n, true });
+        todo.push_back({ n->lhs, false });
+      }
+      break;
+    default:
+    {
+      // a literal or variable on the right is folded into the operator
+      bool fused = is_leaf(n->rhs);
+      if (!frame.expanded)
+      {
+        todo.push_back({ n, true });
+        if (!fused) todo.push_back({ n->rhs, false });
+        todo.push_back({ n->lhs, false });
+        break;
+      }
+
+      int index = n->type - AstNode::addition; // add, sub, mul in order
+      if (!fused)
+        emit(static_cast<Instruction::OpCode>(Instruction::add + index), 0, -1);
+      else if (n->rhs->type == AstNode::integer)
+        emit(static_cast<Instruction::OpCode>(Instruction::add_const + index), n->rhs->value, 0);
+      else
+        emit(static_cast<Instruction::OpCode>(Instruction::add_var + index), n->rhs->value, 0);
+    }
+    }
+
+    // first evaluation of a shared node: keep the result for later uses
+    if (shared && frame.expanded)
+    {
+      temp_of[n] = static_cast<int>(result.temp_count);
+      emit(Instruction::store_temp, static_cast<int>(result.temp_count++), 0);
+    }
+  }
+  return result;
+}
+
+// the top of the stack lives in a register; `sp` holds everything below it
+int ExpressionVM::execute(const Instruction* pc, const Instruction* end,
+  const int* variables, int* stack, int* temps)
+{
+  int top = 0;
+  int* sp = stack;
+
+  for (; pc != end; ++pc)
+  {
+    switch (pc->op)
+    {
+    case Instruction::push_const: *sp++ = top; top = pc->operand; break;
+    case Instruction::load_var: *sp++ = top; top = variables[pc->operand]; break;
+    case Instruction::negate: top = wrapping_neg(top); break;
+    case Instruction::add: top = wrapping_add(*--sp, top); break;
+    case Instruction::sub: top = wrapping_sub(*--sp, top); break;
+    case Instruction::mul: top = wrapping_mul(*--sp, top); break;
+    case Instruction::add_const: top = wrapping_add(top, pc->operand); break;
+    case Instruction::sub_const: top = wrapping_sub(top, pc->operand); break;
+    case Instruction::mul_const: top = wrapping_mul(top, pc->operand); break;
+    case Instruction::add_var: top = wrapping_add(top, variables[pc->operand]); break;
+    case Instruction::sub_var: top = wrapping_sub(top, variables[pc->operand]); break;
+    case Instruction::mul_var: top = wrapping_mul(top, variables[pc->operand]); break;
+    case Instruction::store_temp: temps[pc->operand] = top; break;
+    case Instruction::load_temp: *sp++ = top; top = temps[pc->operand]; break;
+    }
+  }
+  return top;
+}
+
+int main_interpreter_bytecode()
+{
+  ExpressionArena arena;
+  PrattParser parser;
+  ExpressionVM vm;
+
+  string input{ "(x+3)*(y-(z*2-x))-(4*x-(y+1))*(z-7)+x*y*z" };
+  auto ast = parser.parse(input, arena);
+  auto program = compile(ast);
+  cout << input << " compiles to " << program.code.size()
+    << " instructions, max stack " << program.max_stack << "\n";
+
+  // same expression, different bindings each time
+  const int iterations = 10000000;
+  int variables[variable_count] = {};
+  long long tree_sum = 0, vm_sum = 0;
+
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i)
+  {
+    variables['x' - 'a'] = i & 0xff;
+    variables['y' - 'a'] = i >> 8 & 0xff;
+    variables['z' - 'a'] = i >> 16 & 0xff;
+    tree_sum += ast->eval(variables);
+  }
+  chrono::duration<double, nano> tree_time = chrono::steady_clock::now() - start;
+
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i)
+  {
+    variables['x' - 'a'] = i & 0xff;
+    variables['y' - 'a'] = i >> 8 & 0xff;
+    variables['z' - 'a'] = i >> 16 & 0xff;
+    vm_sum += vm.run(program, variables);
+  }
+  chrono::duration<double, nano> vm_time = chrono::steady_clock::now() - start;
+
+  cout << "tree walk: " << tree_time.count() / iterations << " ns/eval\n"
+    << "bytecode:  " << vm_time.count() / iterations << " ns/eval\n"
+    << (tree_sum == vm_sum ? "results match" : "RESULTS DIFFER") << "\n";
+
+  return 0;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "behavioral_interpreter_pratt.h"
+
+struct Instruction
+{
+  enum OpCode : uint8_t
+  {
+    push_const,
+    load_var,
+    negate,
+    add,
+    sub,
+    mul,
+    // fused forms for a leaf right operand: `top = top op operand`
+    add_const,
+    sub_const,
+    mul_const,
+    add_var,
+    sub_var,
+    mul_var,
+    // results of nodes shared in a DAG are computed once and kept
+    store_temp, // temps[operand] = top, top stays
+    load_temp   // push temps[operand]
+  } op;
+  int operand; // literal, variable slot or temp index, unused otherwise
+};
+
+// postfix code for one expression, ready to run any number of times
+struct Program
+{
+  std::vector<Instruction> code;
+  size_t max_stack = 0;
+  size_t temp_count = 0;
+};
+
+// walks the tree once (iteratively, so deep trees are fine); pass `dag` for
+// the output of ExpressionOptimizer, whose nodes may have several parents:
+// each shared node is then evaluated once into a temp
+Program compile(const AstNode* root, bool dag = false);
+
+// stack machine; keeps its value stack between runs
+class ExpressionVM
+{
+public:
+  // `variables` holds variable_count slots, 'a' first
+  int run(const Program& program, const int* variables)
+  {
+    if (stack.size() < program.max_stack)
+      stack.resize(program.max_stack);
+    if (temps.size() < program.temp_count)
+      temps.resize(program.temp_count);
+    return execute(program.code.data(), program.code.data() + program.code.size(),
+      variables, stack.data(), temps.data());
+  }
+
+private:
+  static int execute(const Instruction* pc, const Instruction* end,
+    const int* variables, int* stack, int* temps);
+
+  std::vector<int> stack, temps;
+};
@@ -0,0 +1,245 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+using namespace std;
+
+#include "behavioral_interpreter_cache.h"
+
+namespace
+{
+  bool is_blank(char c)
+  {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+  }
+
+  // characters that form numbers and variable names
+  bool is_word(char c)
+  {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z');
+  }
+
+  // rough heap footprint of one entry: text, code, list and index nodes
+  size_t entry_bytes(const string& text, const Program& program)
+  {
+    return sizeof(Program) + program.code.capacity() * sizeof(Instruction)
+      + text.capacity() + 4 * sizeof(void*) /* list node */
+      + 4 * sizeof(void*) /* index node and bucket */ + 64 /* Entry, control block */;
+  }
+}
+
+ExpressionCache::ExpressionCache(size_t capacity_bytes, size_t shard_count)
+  : shard_capacity{capacity_bytes / max<size_t>(shard_count, 1)}
+{
+  for (size_t i = 0; i < max<size_t>(shard_count, 1); ++i)
+  {
+    shards.emplace_back(new Shard);
+    shards.back()->hand = shards.back()->ring.end();
+  }
+}
+
+string ExpressionCache::normalize(const string& expression)
+{
+  // whitespace between two words is kept as one space: "1 2" is an error,
+  // not 12, and must not share an entry with it
+  string result;
+  result.reserve(expression.size());
+  bool gap = false;
+  for (auto c : expression)
+  {
+    if (is_blank(c))
+    {
+      gap = true;
+      continue;
+    }
+    if (gap && !result.empty() && is_word(result.back()) && is_word(c))
+      result += ' ';
+    result += c;
+    gap = false;
+  }
+  return result;
+}
+
+shared_ptr<const Program> ExpressionCache::get(const string& expression)
+{
+  // only copy the text when there is whitespace to strip
+  auto needs_normalizing = any_of(expression.begin(), expression.end(), is_blank);
+  string normalized;
+  if (needs_normalizing)
+    normalized = normalize(expression);
+  const string& text = needs_normalizing ? normalized : expression;
+
+  Key key{ &text, hash<string>{}(text) };
+  // high bits pick the shard, the index buckets on the low ones
+  auto& shard = *shards[(key.hash >> (sizeof(size_t) * 4)) % shards.size()];
+  {
+    shared_lock<shared_timed_mutex> lock{shard.mutex};
+    auto it = shard.index.find(key);
+    if (it != shard.index.end())
+    {
+      auto& entry = *it->second;
+      if (!entry.referenced.load(memory_order_relaxed))
+        entry.referenced.store(true, memory_order_relaxed);
+      shard.hits.fetch_add(1, memory_order_relaxed);
+      return entry.program;
+    }
+  }
+
+  // parse and compile without holding any lock
+  shard.misses.fetch_add(1, memory_order_relaxed);
+  thread_local ExpressionArena arena;
+  thread_local PrattParser parser;
+  arena.reset();
+  auto program = make_shared<const Program>(compile(parser.parse(text, arena)));
+  return insert(shard, key, move(program));
+}
+
+shared_ptr<const Program> ExpressionCache::insert(Shard& shard, const Key& key,
+  shared_ptr<const Program> program)
+{
+  unique_lock<shared_timed_mutex> lock{shard.mutex};
+
+  // another thread may have compiled the same text meanwhile
+  auto it = shard.index.find(key);
+  if (it != shard.index.end())
+    return it->second->program;
+
+  auto bytes = entry_bytes(*key.text, *program);
+  if (bytes > shard_capacity)
+    return program; // too big to ever fit: hand it out uncached
+
+  // CLOCK sweep: referenced entries get a second chance, the rest go
+  while (shard.bytes + bytes > shard_capacity)
+  {
+    if (shard.hand == shard.ring.end())
+      shard.hand = shard.ring.begin();
+    if (shard.hand->referenced.load(memory_order_relaxed))
+    {
+      shard.hand->referenced.store(false, memory_order_relaxed);
+      ++shard.hand;
+      continue;
+    }
+    shard.bytes -= shard.hand->bytes;
+    shard.index.erase(Key{ &shard.hand->text, shard.hand->hash });
+    shard.hand = shard.ring.erase(shard.hand);
+    shard.evictions.fetch_add(1, memory_order_relaxed);
+  }
+
+  // new entries go just behind the hand, i.e. they are swept last
+  auto entry = shard.ring.emplace(shard.hand, *key.text, key.hash, move(program), bytes);
+  shard.index.emplace(Key{ &entry->text, entry->hash }, entry);
+  shard.bytes += bytes;
+  return entry->program;
+}
+
+ExpressionCache::Stats ExpressionCache::stats() const
+{
+  Stats result;
+  for (auto& shard : shards)
+  {
+    shared_lock<shared_timed_mutex> lock{shard->mutex};
+    result.hits += shard->hits.load(memory_order_relaxed);
+    result.misses += shard->misses.load(memory_order_relaxed);
+    result.evictions += shard->evictions.load(memory_order_relaxed);
+    result.entries += shard->index.size();
+    result.bytes += shard->bytes;
+  }
+  return result;
+}
+
+namespace
+{
+  string random_expression(mt19937& rng)
+  {
+    const char* operators = "+-*";
+    uniform_int_distribution<int> leaf(0, 99), op(0, 2), count(3, 12);
+    string result;
+    for (int i = 0, n = count(rng); i < n; ++i)
+    {
+      if (i) result += operators[op(rng)];
+      auto l = leaf(rng);
+      if (l < 30) result += char('x' + l % 3);
+      else result += to_string(l);
+    }
+    return "(" + result + ")*(x - " + to_string(leaf(rng)) + ")";
+  }
+
+  // ranks drawn with probability proportional to 1 / rank^s
+  vector<size_t> zipf_workload(size_t distinct, size_t length, double s, mt19937& rng)
+  {
+    vector<double> cdf(distinct);
+    double total = 0;
+    for (size_t i = 0; i < distinct; ++i)
+      cdf[i] = total += 1.0 / pow(static_cast<double>(i + 1), s);
+    uniform_real_distribution<double> u(0, total);
+
+    vector<size_t> result(length);
+    for (auto& r : result)
+      r = min<size_t>(lower_bound(cdf.begin(), cdf.end(), u(rng)) - cdf.begin(), distinct - 1);
+    return result;
+  }
+}
+
+int main_interpreter_cache()
+{
+  mt19937 rng{ 42 };
+  const size_t distinct = 10000, lookups = 4000000;
+  vector<string> expressions(distinct);
+  for (auto& e : expressions)
+    e = random_expression(rng);
+  auto workload = zipf_workload(distinct, lookups, 1.0, rng);
+
+  auto threads = max(1u, thread::hardware_concurrency());
+  auto run = [&](const char* name, function<int(const string&, const int*)> eval) {
+    atomic<long long> checksum{ 0 };
+    auto start = chrono::steady_clock::now();
+    vector<thread> pool;
+    for (unsigned t = 0; t < threads; ++t)
+      pool.emplace_back([&, t] {
+        int variables[variable_count] = {};
+        long long sum = 0;
+        for (size_t i = t; i < lookups; i += threads)
+        {
+          variables['x' - 'a'] = static_cast<int>(i);
+          sum += eval(expressions[workload[i]], variables);
+        }
+        checksum += sum;
+      });
+    for (auto& th : pool) th.join();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << name << ": " << lookups / elapsed.count() / 1e6 << " M lookups/s on "
+      << threads << " threads\n";
+    return checksum.load();
+  };
+
+  auto expected = run("parse every time", [](const string& text, const int* variables) {
+    thread_local ExpressionArena arena;
+    thread_local PrattParser parser;
+    thread_local ExpressionVM vm;
+    arena.reset();
+    return vm.run(compile(parser.parse(text, arena)), variables);
+  });
+
+  for (size_t capacity : { 64u << 10, 512u << 10, 8u << 20 })
+  {
+    ExpressionCache cache{ capacity };
+    auto checksum = run("cached", [&](const string& text, const int* variables) {
+      thread_local ExpressionVM vm;
+      return vm.run(*cache.get(text), variables);
+    });
+    auto s = cache.stats();
+    cout << "  capacity " << (capacity >> 10) << " KiB: hit rate " << s.hit_rate() * 100
+      << "%, " << s.entries << " entries, " << s.bytes << " bytes, "
+      << s.evictions << " evictions"
+      << (checksum == expected ? "" : ", RESULTS DIFFER") << "\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "behavioral_interpreter_bytecode.h"
+
+// maps expression text to its compiled Program. the text is normalized
+// first: whitespace is dropped, except one space between two numbers or
+// variables, where it changes the meaning
+//
+// the cache is split into shards, each behind a reader/writer lock: hits
+// only take the shared lock and mark the entry as recently used, so
+// concurrent readers never block each other. eviction uses the CLOCK
+// (second chance) approximation of LRU, which needs no list reordering on
+// a hit
+class ExpressionCache
+{
+public:
+  explicit ExpressionCache(size_t capacity_bytes, size_t shard_count = 16);
+
+  // parses and compiles on a miss; throws invalid_argument for bad input
+  std::shared_ptr<const Program> get(const std::string& expression);
+
+  struct Stats
+  {
+    size_t hits = 0, misses = 0, evictions = 0;
+    size_t entries = 0, bytes = 0;
+
+    double hit_rate() const
+    {
+      return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0;
+    }
+  };
+  Stats stats() const;
+
+  static std::string normalize(const std::string& expression);
+
+private:
+  struct Entry
+  {
+    std::string text;
+    size_t hash;
+    std::shared_ptr<const Program> program;
+    size_t bytes;
+    mutable std::atomic<bool> referenced;
+
+    Entry(std::string text, size_t hash, std::shared_ptr<const Program> program, size_t bytes)
+      : text{std::move(text)}, hash{hash}, program{std::move(program)}, bytes{bytes},
+        referenced{false} {}
+  };
+
+  // keys point into the entries themselves, so the text is stored once;
+  // the hash is computed once per lookup and also picks the shard
+  struct Key
+  {
+    const std::string* text;
+    size_t hash;
+
+    bool operator==(const Key& other) const
+    {
+      return hash == other.hash && *text == *other.text;
+    }
+  };
+  struct KeyHash
+  {
+    size_t operator()(const Key& key) const { return key.hash; }
+  };
+  using Index = std::unordered_map<Key, std::list<Entry>::iterator, KeyHash>;
+
+  struct Shard
+  {
+    mutable std::shared_timed_mutex mutex;
+    std::list<Entry> ring; // clock order; the hand sweeps it circularly
+    std::list<Entry>::iterator hand;
+    Index index;
+    size_t bytes = 0;
+    std::atomic<size_t> hits{0}, misses{0}, evictions{0};
+  };
+
+  std::shared_ptr<const Program> insert(Shard& shard, const Key& key,
+    std::shared_ptr<const Program> program);
+
+  size_t shard_capacity;
+  std::vector<std::unique_ptr<Shard>> shards;
+};
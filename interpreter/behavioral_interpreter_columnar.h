@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "behavioral_interpreter_bytecode.h"
+
+// runs a compiled Program over whole columns instead of one binding at a
+// time: each instruction is applied to a block of rows with a fixed-length
+// loop the compiler turns into SIMD code when optimizing (GCC does from -O2
+// on; the top-level CMakeLists sets no -O, so configure with
+// -DCMAKE_BUILD_TYPE=Release to get it)
+class BatchEvaluator
+{
+public:
+  static constexpr size_t block_size = 512;
+
+  // `columns[v]` points at `rows` values of variable v ('a' first); columns
+  // for variables the program never reads may be null
+  void evaluate(const Program& program, const int* const* columns,
+    size_t rows, int* out);
+
+  // writes the indices of rows where the expression is non-zero to
+  // `selection` (room for `rows` entries) and returns how many there are
+  size_t filter(const Program& program, const int* const* columns,
+    size_t rows, uint32_t* selection);
+
+private:
+  // leaves the block's results in the first stack slot and returns it
+  const int* run_block(const Program& program, const int* const* columns);
+
+  void prepare(const Program& program, const int* const* columns);
+  // points `block_columns` at `count` rows starting at `row`, padding a
+  // short last block with zeros
+  void seek(const int* const* columns, size_t row, size_t count);
+
+  std::vector<int> stack; // max_stack slots of block_size values
+  std::vector<int> temps; // temp_count slots of block_size values
+  std::vector<int> tail;  // zero-padded copies for the last partial block
+  std::vector<uint8_t> used;
+  const int* block_columns[variable_count] = {};
+};
@@ -0,0 +1,183 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <utility>
+using namespace std;
+
+#include "behavioral_interpreter_optimizer.h"
+#include "behavioral_interpreter_bytecode.h"
+
+namespace
+{
+  bool is_constant(const AstNode* n, int value)
+  {
+    return n->type == AstNode::integer && n->value == value;
+  }
+
+  // operand order for commutative operators: literals, then variables, then
+  // interior nodes, so leaves end up on the right where compile() fuses them
+  bool goes_after(const AstNode* a, const AstNode* b)
+  {
+    auto rank = [](const AstNode* n) {
+      return n->type == AstNode::integer ? 0 : n->type == AstNode::variable ? 1 : 2;
+    };
+    if (rank(a) != rank(b)) return rank(a) < rank(b);
+    if (rank(a) < 2) return a->value < b->value;
+    return less<const AstNode*>{}(a, b);
+  }
+}
+
+const AstNode* ExpressionOptimizer::make(AstNode::Type type, int value,
+  const AstNode* lhs, const AstNode* rhs, ExpressionArena& arena)
+{
+  auto integer = [&](int v) { return make(AstNode::integer, v, nullptr, nullptr, arena); };
+
+  switch (type)
+  {
+  case AstNode::negation:
+    if (lhs->type == AstNode::integer) return integer(wrapping_neg(lhs->value));
+    if (lhs->type == AstNode::negation) return lhs->lhs;
+    break;
+  case AstNode::addition:
+    if (lhs->type == AstNode::integer && rhs->type == AstNode::integer)
+      return integer(wrapping_add(lhs->value, rhs->value));
+    if (is_constant(lhs, 0)) return rhs;
+    if (is_constant(rhs, 0)) return lhs;
+    if (goes_after(lhs, rhs)) swap(lhs, rhs);
+    break;
+  case AstNode::subtraction:
+    if (lhs->type == AstNode::integer && rhs->type == AstNode::integer)
+      return integer(wrapping_sub(lhs->value, rhs->value));
+    if (is_constant(rhs, 0)) return lhs;
+    if (lhs == rhs) return integer(0); // canonical nodes: same pointer, same value
+    if (is_constant(lhs, 0)) return make(AstNode::negation, 0, rhs, nullptr, arena);
+    break;
+  case AstNode::multiplication:
+    if (lhs->type == AstNode::integer && rhs->type == AstNode::integer)
+      return integer(wrapping_mul(lhs->value, rhs->value));
+    if (is_constant(lhs, 0) || is_constant(rhs, 0)) return integer(0);
+    if (is_constant(lhs, 1)) return rhs;
+    if (is_constant(rhs, 1)) return lhs;
+    if (is_constant(lhs, -1)) return make(AstNode::negation, 0, rhs, nullptr, arena);
+    if (is_constant(rhs, -1)) return make(AstNode::negation, 0, lhs, nullptr, arena);
+    if (goes_after(lhs, rhs)) swap(lhs, rhs);
+    break;
+  default:
+    break;
+  }
+
+  NodeKey key{ type, value, lhs, rhs };
+  auto it = table.find(key);
+  if (it != table.end())
+    return it->second;
+  auto node = arena.make<AstNode>(type, value, lhs, rhs);
+  table.emplace(key, node);
+  return node;
+}
+
+const AstNode* ExpressionOptimizer::optimize(const AstNode* root, ExpressionArena& arena)
+{
+  table.clear();
+  rewritten.clear();
+
+  // post-order with an explicit stack; children are rewritten first
+  struct Frame
+  {
+    const AstNode* node;
+    bool expanded;
+  };
+  vector<Frame> todo{ { root, false } };
+
+  while (!todo.empty())
+  {
+    auto frame = todo.back();
+    todo.pop_back();
+    auto n = frame.node;
+    if (rewritten.count(n))
+      continue;
+
+    bool leaf = n->type == AstNode::integer || n->type == AstNode::variable;
+    if (!leaf && !frame.expanded)
+    {
+      todo.push_back({ n, true });
+      if (n->rhs) todo.push_back({ n->rhs, false });
+      todo.push_back({ n->lhs, false });
+      continue;
+    }
+
+    auto lhs = leaf ? nullptr : rewritten[n->lhs];
+    auto rhs = leaf || !n->rhs ? nullptr : rewritten[n->rhs];
+    rewritten[n] = make(n->type, leaf ? n->value : 0, lhs, rhs, arena);
+  }
+  return rewritten[root];
+}
+
+namespace
+{
+  // each level repeats the previous one twice and mixes in constant
+  // subtrees and identities, so the text doubles while the unique work
+  // grows by a couple of nodes
+  string redundant_input(int levels)
+  {
+    string e{ "x" };
+    for (int i = 0; i < levels; ++i)
+      e = "((" + e + ")-y*1)+((" + e + ")+(2*3-6))-(x-x)";
+    return e;
+  }
+}
+
+int main_interpreter_optimizer()
+{
+  ExpressionArena arena;
+  PrattParser parser;
+  ExpressionOptimizer optimizer;
+  ExpressionVM vm;
+
+  for (auto input : { "x-0", "1*(y+0)*(3-2)", "(x+y)*(y+x)-(x+y)", "--x*-1", "2*3-6+x*(4-4)" })
+  {
+    auto optimized = compile(optimizer.optimize(parser.parse(input, arena), arena), true);
+    cout << input << ": " << optimized.code.size() << " instructions, "
+      << optimized.temp_count << " temps\n";
+  }
+
+  for (int levels : { 8, 12, 16 })
+  {
+    auto input = redundant_input(levels);
+    auto ast = parser.parse(input, arena);
+    auto plain = compile(ast);
+    auto optimized = compile(optimizer.optimize(ast, arena), true);
+
+    const int iterations = 2000;
+    int variables[variable_count] = {};
+    long long plain_sum = 0, optimized_sum = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+      variables['x' - 'a'] = i & 0xff;
+      variables['y' - 'a'] = i >> 8 & 0xff;
+      plain_sum += vm.run(plain, variables);
+    }
+    chrono::duration<double, micro> plain_time = chrono::steady_clock::now() - start;
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+      variables['x' - 'a'] = i & 0xff;
+      variables['y' - 'a'] = i >> 8 & 0xff;
+      optimized_sum += vm.run(optimized, variables);
+    }
+    chrono::duration<double, micro> optimized_time = chrono::steady_clock::now() - start;
+
+    cout << input.size() << " chars: " << plain.code.size() << " -> "
+      << optimized.code.size() << " instructions ("
+      << optimizer.unique_nodes() << " unique nodes), "
+      << plain_time.count() / iterations << " -> "
+      << optimized_time.count() / iterations << " us/eval"
+      << (plain_sum == optimized_sum ? "" : ", RESULTS DIFFER") << "\n";
+    arena.reset();
+  }
+
+  return 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+
+#include "behavioral_interpreter_pratt.h"
+
+// rewrites a parsed expression so that evaluation only pays for unique work:
+//  - constant subtrees are folded (2*3-6 becomes 0)
+//  - identities are simplified (x-0, x*1, 0*x, x-x, --x, ...)
+//  - structurally identical subtrees are hash-consed into one node, so the
+//    result is a DAG; compile() evaluates each shared node once
+class ExpressionOptimizer
+{
+public:
+  // the rewritten nodes are allocated in `arena`; `root` is left untouched
+  const AstNode* optimize(const AstNode* root, ExpressionArena& arena);
+
+  // distinct interior and leaf nodes produced by the last optimize()
+  size_t unique_nodes() const { return table.size(); }
+
+private:
+  struct NodeKey
+  {
+    AstNode::Type type;
+    int value;
+    const AstNode *lhs, *rhs;
+
+    bool operator==(const NodeKey& other) const
+    {
+      return type == other.type && value == other.value
+        && lhs == other.lhs && rhs == other.rhs;
+    }
+  };
+
+  struct NodeKeyHash
+  {
+    size_t operator()(const NodeKey& k) const
+    {
+      auto h = std::hash<const void*>{}(k.lhs) * 31 + std::hash<const void*>{}(k.rhs);
+      return (h * 31 + static_cast<size_t>(k.value)) * 31 + k.type;
+    }
+  };
+
+  // simplified, hash-consed constructor; children are already canonical
+  const AstNode* make(AstNode::Type type, int value,
+    const AstNode* lhs, const AstNode* rhs, ExpressionArena& arena);
+
+  std::unordered_map<NodeKey, const AstNode*, NodeKeyHash> table;
+  std::unordered_map<const AstNode*, const AstNode*> rewritten;
+};
@@ -0,0 +1,233 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <chrono>
+#include <stdexcept>
+using namespace std;
+
+#include "behavioral_interpreter_pratt.h"
+
+void ExpressionArena::next_block(size_t at_least)
+{
+  if (!blocks.empty() && current != nullptr)
+    ++active;
+  // reuse blocks kept by reset() when they are big enough
+  while (active < blocks.size() && blocks[active].size < at_least)
+    ++active;
+  if (active >= blocks.size())
+  {
+    auto size = max(block_size, at_least);
+    auto data = static_cast<char*>(malloc(size));
+    if (!data) throw bad_alloc{};
+    blocks.push_back(Block{data, size});
+    active = blocks.size() - 1;
+  }
+  current = blocks[active].data;
+  limit = current + blocks[active].size;
+}
+
+void ExpressionArena::reset()
+{
+  active = 0;
+  current = blocks.empty() ? nullptr : blocks[0].data;
+  limit = blocks.empty() ? nullptr : blocks[0].data + blocks[0].size;
+}
+
+void ExpressionArena::release()
+{
+  for (auto& b : blocks)
+    free(b.data);
+  blocks.clear();
+  active = 0;
+  current = limit = nullptr;
+}
+
+size_t ExpressionArena::bytes_used() const
+{
+  if (current == nullptr) return 0;
+  size_t result = 0;
+  for (size_t i = 0; i < active; ++i)
+    result += blocks[i].size;
+  return result + (current - blocks[active].data);
+}
+
+size_t ExpressionArena::bytes_reserved() const
+{
+  size_t result = 0;
+  for (auto& b : blocks)
+    result += b.size;
+  return result;
+}
+
+int AstNode::eval(const int* variables) const
+{
+  switch (type)
+  {
+  case integer: return value;
+  case variable: return variables[value];
+  case negation: return wrapping_neg(lhs->eval(variables));
+  case addition: return wrapping_add(lhs->eval(variables), rhs->eval(variables));
+  case subtraction: return wrapping_sub(lhs->eval(variables), rhs->eval(variables));
+  case multiplication: return wrapping_mul(lhs->eval(variables), rhs->eval(variables));
+  }
+  return 0;
+}
+
+namespace
+{
+  // binding power of each pending operator; lparen never reduces
+  const int precedence[] = { 0, 1, 1, 2, 3 };
+}
+
+void PrattParser::reduce(ExpressionArena& arena)
+{
+  auto op = operators.back();
+  operators.pop_back();
+
+  if (op == negate)
+  {
+    auto operand = operands.back();
+    operands.back() = arena.make<AstNode>(AstNode::negation, 0, operand, nullptr);
+    return;
+  }
+
+  auto rhs = operands.back();
+  operands.pop_back();
+  auto lhs = operands.back();
+  auto type = op == plus ? AstNode::addition
+    : op == minus ? AstNode::subtraction
+    : AstNode::multiplication;
+  operands.back() = arena.make<AstNode>(type, 0, lhs, rhs);
+}
+
+const AstNode* PrattParser::parse(const char* first, const char* last, ExpressionArena& arena)
+{
+  operands.clear();
+  operators.clear();
+
+  auto error = [&](const char* what, const char* at) {
+    throw invalid_argument(string{what} + " at offset " + to_string(at - first));
+  };
+
+  bool expect_operand = true;
+  for (auto p = first; p != last; ++p)
+  {
+    auto c = *p;
+    if (isspace(static_cast<unsigned char>(c)))
+      continue;
+
+    if (expect_operand)
+    {
+      if (isdigit(static_cast<unsigned char>(c)))
+      {
+        int value = c - '0';
+        while (p + 1 != last && isdigit(static_cast<unsigned char>(p[1])))
+        {
+          int digit = p[1] - '0';
+          if (value > (INT_MAX - digit) / 10)
+            error("number out of range", p + 1);
+          value = value * 10 + digit;
+          ++p;
+        }
+        operands.push_back(arena.make<AstNode>(AstNode::integer, value, nullptr, nullptr));
+        expect_operand = false;
+      }
+      else if (c >= 'a' && c <= 'z')
+      {
+        operands.push_back(arena.make<AstNode>(AstNode::variable, c - 'a', nullptr, nullptr));
+        expect_operand = false;
+      }
+      else if (c == '(') operators.push_back(lparen);
+      else if (c == '-') operators.push_back(negate);
+      else error("expected a number, variable or '('", p);
+      continue;
+    }
+
+    Op op;
+    switch (c)
+    {
+    case '+': op = plus; break;
+    case '-': op = minus; break;
+    case '*': op = times; break;
+    case ')':
+      while (!operators.empty() && operators.back() != lparen)
+        reduce(arena);
+      if (operators.empty())
+        error("unbalanced ')'", p);
+      operators.pop_back();
+      continue;
+    default:
+      error("expected an operator or ')'", p);
+      continue;
+    }
+
+    // all binary operators are left-associative
+    while (!operators.empty() && precedence[operators.back()] >= precedence[op])
+      reduce(arena);
+    operators.push_back(op);
+    expect_operand = true;
+  }
+
+  if (expect_operand)
+    error("unexpected end of input", last);
+  while (!operators.empty())
+  {
+    if (operators.back() == lparen)
+      error("unbalanced '('", last);
+    reduce(arena);
+  }
+  return operands.back();
+}
+
+namespace
+{
+  // ((((...(1+1)+1)...)+1) with the parentheses nested `depth` levels deep
+  string nested_input(int depth)
+  {
+    string result(depth, '(');
+    result += "1";
+    for (int i = 0; i < depth; ++i)
+      result += "+1)";
+    return result;
+  }
+}
+
+int main_interpreter_pratt()
+{
+  ExpressionArena arena;
+  PrattParser parser;
+  int variables[variable_count] = {};
+  variables['x' - 'a'] = 5;
+
+  for (auto input : { "(13-4)-(12+1)", "2+3*(4-(1+x))*-2", "((1+2)*(3+4))-x" })
+  {
+    auto ast = parser.parse(input, arena);
+    cout << input << " = " << ast->eval(variables) << "\n";
+  }
+  arena.reset();
+
+  // parse time per character should stay flat as nesting gets deeper
+  for (int depth : { 1000, 10000, 100000, 1000000 })
+  {
+    auto input = nested_input(depth);
+    const int repeats = 10000000 / static_cast<int>(input.size()) + 1;
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i)
+    {
+      arena.reset();
+      parser.parse(input, arena);
+    }
+    chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+
+    cout << "depth " << depth << ": "
+      << elapsed.count() / repeats / input.size() << " ns/char, "
+      << arena.bytes_used() << " arena bytes\n";
+  }
+  arena.release();
+
+  return 0;
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// bump allocator: nodes are carved out of large blocks and
+// the whole tree goes away in a single release()/reset()
+class ExpressionArena
+{
+public:
+  explicit ExpressionArena(size_t block_size = 64 * 1024)
+    : block_size{block_size} {}
+
+  ~ExpressionArena() { release(); }
+
+  ExpressionArena(const ExpressionArena&) = delete;
+  ExpressionArena& operator=(const ExpressionArena&) = delete;
+
+  void* allocate(size_t size, size_t alignment)
+  {
+    auto p = (reinterpret_cast<uintptr_t>(current) + alignment - 1) & ~(alignment - 1);
+    if (current == nullptr || p + size > reinterpret_cast<uintptr_t>(limit))
+    {
+      next_block(size + alignment);
+      p = (reinterpret_cast<uintptr_t>(current) + alignment - 1) & ~(alignment - 1);
+    }
+    current = reinterpret_cast<char*>(p + size);
+    return reinterpret_cast<void*>(p);
+  }
+
+  // only trivially destructible types: nothing is ever destroyed individually
+  template <typename T, typename... Args> T* make(Args&&... args)
+  {
+    static_assert(std::is_trivially_destructible<T>::value,
+      "arena objects are never destroyed individually");
+    return new (allocate(sizeof(T), alignof(T))) T{std::forward<Args>(args)...};
+  }
+
+  // rewinds to the first block, keeping the memory for the next tree
+  void reset();
+  // gives all blocks back to the system
+  void release();
+
+  size_t bytes_used() const;
+  size_t bytes_reserved() const;
+
+private:
+  struct Block
+  {
+    char* data;
+    size_t size;
+  };
+
+  void next_block(size_t at_least);
+
+  size_t block_size;
+  std::vector<Block> blocks;
+  size_t active = 0; // index of the block `current` points into
+  char* current = nullptr;
+  char* limit = nullptr;
+};
+
+// variables are single lowercase letters, as in the coding exercise
+constexpr int variable_count = 26;
+
+// integer arithmetic wraps around on overflow (done in unsigned, where
+// it is defined), so every evaluator gives the same result for any input
+inline int wrapping_add(int a, int b) { return static_cast<int>(static_cast<unsigned>(a) + static_cast<unsigned>(b)); }
+inline int wrapping_sub(int a, int b) { return static_cast<int>(static_cast<unsigned>(a) - static_cast<unsigned>(b)); }
+inline int wrapping_mul(int a, int b) { return static_cast<int>(static_cast<unsigned>(a) * static_cast<unsigned>(b)); }
+inline int wrapping_neg(int a) { return static_cast<int>(0u - static_cast<unsigned>(a)); }
+
+struct AstNode
+{
+  enum Type : uint8_t
+  {
+    integer,
+    variable,
+    negation,
+    addition,
+    subtraction,
+    multiplication
+  } type;
+  int value; // literal for integers, slot (0 = 'a') for variables
+  const AstNode *lhs, *rhs;
+
+  // reference tree-walking evaluation; `variables` holds variable_count slots
+  int eval(const int* variables) const;
+};
+
+// precedence climbing over the raw characters: no token vector, no
+// recursion (nesting depth only grows the explicit stacks), one arena
+// allocation per node
+class PrattParser
+{
+public:
+  // throws invalid_argument on malformed input, including literals that
+  // don't fit an int
+  const AstNode* parse(const char* first, const char* last, ExpressionArena& arena);
+
+  const AstNode* parse(const std::string& input, ExpressionArena& arena)
+  {
+    return parse(input.data(), input.data() + input.size(), arena);
+  }
+
+private:
+  enum Op : uint8_t { lparen, plus, minus, times, negate };
+
+  void reduce(ExpressionArena& arena);
+
+  // kept between calls so steady-state parsing does not touch the heap
+  std::vector<const AstNode*> operands;
+  std::vector<Op> operators;
+};
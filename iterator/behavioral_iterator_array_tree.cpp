@@ -0,0 +1,169 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+using namespace std;
+
+#include "behavioral_iterator_array_tree.h"
+
+namespace
+{
+  // the node layout of BinaryTree in behavioral_iterator.cpp.txt
+  struct LinkedNode
+  {
+    int value;
+    LinkedNode *left = nullptr, *right = nullptr, *parent = nullptr;
+    void* tree = nullptr;
+
+    explicit LinkedNode(int value) : value{ value } {}
+
+    ~LinkedNode()
+    {
+      delete left;
+      delete right;
+    }
+  };
+
+  // balanced, nodes allocated in pre-order as a freshly built tree has them
+  LinkedNode* build(const int* first, const int* last, LinkedNode* parent)
+  {
+    if (first == last)
+      return nullptr;
+    auto middle = first + (last - first) / 2;
+    auto node = new LinkedNode{ *middle };
+    node->parent = parent;
+    node->left = build(first, middle, node);
+    node->right = build(middle + 1, last, node);
+    return node;
+  }
+
+  const LinkedNode* lower_bound(const LinkedNode* node, int key)
+  {
+    const LinkedNode* found = nullptr;
+    while (node)
+    {
+      if (node->value < key)
+        node = node->right;
+      else
+      {
+        found = node;
+        node = node->left;
+      }
+    }
+    return found;
+  }
+
+  // stackless successors over parent pointers
+  const LinkedNode* next_in_order(const LinkedNode* n)
+  {
+    if (n->right)
+    {
+      n = n->right;
+      while (n->left) n = n->left;
+      return n;
+    }
+    auto p = n->parent;
+    while (p && n == p->right)
+    {
+      n = p;
+      p = p->parent;
+    }
+    return p;
+  }
+
+  const LinkedNode* next_pre_order(const LinkedNode* n)
+  {
+    if (n->left) return n->left;
+    if (n->right) return n->right;
+    auto p = n->parent;
+    while (p && (n == p->right || !p->right))
+    {
+      n = p;
+      p = p->parent;
+    }
+    return p ? p->right : nullptr;
+  }
+
+  const LinkedNode* first_post_order(const LinkedNode* n)
+  {
+    while (n->left || n->right)
+      n = n->left ? n->left : n->right;
+    return n;
+  }
+
+  const LinkedNode* next_post_order(const LinkedNode* n)
+  {
+    auto p = n->parent;
+    if (p && n == p->left && p->right)
+      return first_post_order(p->right);
+    return p;
+  }
+
+  template <typename F> double milliseconds(F f)
+  {
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  }
+}
+
+int main_iterator_array_tree()
+{
+  const int n = 10000000;
+  vector<int> sorted(n);
+  iota(sorted.begin(), sorted.end(), 0);
+  for (auto& v : sorted) v *= 2; // odd keys miss
+
+  auto linked = build(sorted.data(), sorted.data() + n, nullptr);
+  ArrayBinaryTree<int> array{ sorted.begin(), sorted.end() };
+
+  mt19937 rng{ 10 };
+  vector<int> keys(1000000);
+  for (auto& k : keys) k = static_cast<int>(rng() % (2 * n));
+
+  long long linked_found = 0, array_found = 0, vector_found = 0;
+  auto linked_lookup = milliseconds([&] {
+    for (auto k : keys)
+      if (auto node = lower_bound(linked, k)) linked_found += node->value;
+  });
+  auto array_lookup = milliseconds([&] {
+    for (auto k : keys)
+    {
+      auto it = array.lower_bound(k);
+      if (it != array.end()) array_found += *it;
+    }
+  });
+  auto vector_lookup = milliseconds([&] {
+    for (auto k : keys)
+    {
+      auto it = std::lower_bound(sorted.begin(), sorted.end(), k);
+      if (it != sorted.end()) vector_found += *it;
+    }
+  });
+
+  long long sums[6] = {};
+  double times[6];
+  times[0] = milliseconds([&] { for (auto p = first_post_order(linked); p; p = next_post_order(p)) sums[0] += p->value; });
+  times[1] = milliseconds([&] { for (auto v : array.post_order()) sums[1] += v; });
+  times[2] = milliseconds([&] { for (const LinkedNode* p = linked; p; p = next_pre_order(p)) sums[2] += p->value; });
+  times[3] = milliseconds([&] { for (auto v : array.pre_order) sums[3] += v; });
+  const LinkedNode* leftmost = linked;
+  while (leftmost->left) leftmost = leftmost->left;
+  times[4] = milliseconds([&] { for (auto p = leftmost; p; p = next_in_order(p)) sums[4] += p->value; });
+  times[5] = milliseconds([&] { for (auto v : array) sums[5] += v; });
+
+  cout << n << " nodes: " << n * sizeof(LinkedNode) / 1e6 << " MB of nodes vs "
+    << n * sizeof(int) / 1e6 << " MB array\n"
+    << keys.size() << " lookups: linked " << linked_lookup << " ms, array " << array_lookup
+    << " ms, binary search on the sorted vector " << vector_lookup << " ms"
+    << (linked_found == array_found && array_found == vector_found ? "" : " (RESULTS DIFFER)") << "\n";
+  const char* names[] = { "post-order", "pre-order", "in-order" };
+  for (int t = 0; t < 3; ++t)
+    cout << names[t] << ": linked " << times[2 * t] << " ms, array " << times[2 * t + 1] << " ms"
+      << (sums[2 * t] == sums[2 * t + 1] ? "" : " (RESULTS DIFFER)") << "\n";
+
+  delete linked;
+  return 0;
+}
@@ -0,0 +1,218 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <boost/iterator/iterator_facade.hpp>
+#include "behavioral_iterator_block.h"
+
+// binary search tree without nodes: the values sit in one array in BFS
+// ("Eytzinger") order - root at index 1, the children of i at 2i and 2i+1 -
+// so parent and child links are index arithmetic and the tree costs no
+// memory beyond the values. the tree is complete and built from sorted
+// input; lookups prefetch the cache line holding the descendants four
+// levels down, so the memory latency of deep levels overlaps with the
+// comparisons above them.
+//
+// traversals keep the shape of BinaryTree's interface: begin()/end() walk
+// in order, `pre_order` is a traversal object and post_order() returns
+// one; all three are plain forward iterators over the values
+template <typename T> class ArrayBinaryTree
+{
+  enum class Order { pre, in, post };
+
+public:
+  template <Order order>
+  class Iterator : public boost::iterator_facade<Iterator<order>, const T, boost::forward_traversal_tag>
+  {
+  public:
+    Iterator() = default;
+    Iterator(const ArrayBinaryTree* tree, size_t index) : tree{tree}, index{index} {}
+
+    // position in the array, 0 at the end
+    size_t position() const { return index; }
+
+  private:
+    friend class boost::iterator_core_access;
+
+    void increment()
+    {
+      switch (order)
+      {
+      case Order::pre: index = tree->next_pre_order(index); break;
+      case Order::in: index = tree->next_in_order(index); break;
+      case Order::post: index = tree->next_post_order(index); break;
+      }
+    }
+
+    bool equal(const Iterator& other) const { return index == other.index; }
+    const T& dereference() const { return tree->values[index]; }
+
+    const ArrayBinaryTree* tree = nullptr;
+    size_t index = 0;
+  };
+
+  using iterator = Iterator<Order::in>;
+  using pre_order_iterator = Iterator<Order::pre>;
+  using post_order_iterator = Iterator<Order::post>;
+
+  template <typename It> struct Traversal
+  {
+    It first, last;
+    It begin() const { return first; }
+    It end() const { return last; }
+  };
+
+  // `sorted` has to be in ascending order
+  template <typename InputIt> ArrayBinaryTree(InputIt first, InputIt last)
+    : values(1 + std::distance(first, last)), n{values.size() - 1}
+  {
+    for (auto i = first_in_order(); i; i = next_in_order(i))
+      values[i] = *first++;
+    pre_order = {{this, n ? 1u : 0u}, {}};
+  }
+
+  // the traversal objects point back at the tree
+  ArrayBinaryTree(const ArrayBinaryTree&) = delete;
+  ArrayBinaryTree& operator=(const ArrayBinaryTree&) = delete;
+
+  size_t size() const { return n; }
+
+  iterator begin() const { return {this, first_in_order()}; }
+  iterator end() const { return {}; }
+
+  Traversal<pre_order_iterator> pre_order;
+
+  Traversal<post_order_iterator> post_order() const { return {{this, first_post_order()}, {}}; }
+
+  // first element not less than `key`, in order
+  iterator lower_bound(const T& key) const
+  {
+    const T* data = values.data();
+    size_t i = 1;
+    while (i <= n)
+    {
+#ifdef __GNUC__
+      __builtin_prefetch(data + i * prefetch_stride);
+#endif
+      // branch-free: the comparison picks the child
+      i = 2 * i + (data[i] < key);
+    }
+    // undo the right turns taken since the last left turn, and that left
+    // turn; what's left is the last node we went left at, or 0
+    while (i & 1)
+      i >>= 1;
+    return {this, i >> 1};
+  }
+
+  bool contains(const T& key) const
+  {
+    auto it = lower_bound(key);
+    return it != end() && !(key < *it);
+  }
+
+  // all values as one block, in storage (level) order rather than in order
+  template <typename F> void for_each_block(F&& f) const
+  {
+    if (n)
+      f(Block<const T>{values.data() + 1, n});
+  }
+
+  // the element at position `rank` in order, end() for rank == size()
+  iterator at(size_t rank) const
+  {
+    if (rank >= n)
+      return end();
+    size_t i = 1;
+    while (true)
+    {
+      auto left = subtree_size(2 * i);
+      if (rank < left)
+        i = 2 * i;
+      else if (rank == left)
+        return {this, i};
+      else
+      {
+        rank -= left + 1;
+        i = 2 * i + 1;
+      }
+    }
+  }
+
+  // cuts the in-order sequence into at most `parts` consecutive subranges
+  // of equal size (give or take one), found by rank through subtree sizes
+  std::vector<std::pair<iterator, iterator>> split(size_t parts) const
+  {
+    std::vector<std::pair<iterator, iterator>> ranges;
+    parts = std::min(parts, n);
+    auto first = begin();
+    for (size_t p = 1; p <= parts; ++p)
+    {
+      auto last = at(n * p / parts);
+      ranges.emplace_back(first, last);
+      first = last;
+    }
+    return ranges;
+  }
+
+private:
+  // the descendants of i k levels down start at i * 2^k; with 16 values to
+  // a cache line (4-byte T) i * 16 is the line with all of them 4 levels down
+  static constexpr size_t prefetch_stride = std::max<size_t>(1, 64 / sizeof(T));
+
+  size_t leftmost(size_t i) const
+  {
+    while (2 * i <= n)
+      i = 2 * i;
+    return i;
+  }
+
+  // the tree is complete, so the size of a subtree follows from its root
+  // index: every level below it is a run of consecutive indices
+  size_t subtree_size(size_t i) const
+  {
+    size_t size = 0;
+    for (size_t width = 1; i <= n; i *= 2, width *= 2)
+      size += std::min(n, i + width - 1) - i + 1;
+    return size;
+  }
+
+  size_t first_in_order() const { return n ? leftmost(1) : 0; }
+
+  size_t next_in_order(size_t i) const
+  {
+    if (2 * i + 1 <= n)
+      return leftmost(2 * i + 1);
+    // up past every ancestor we're the right child of, then one more
+    while (i & 1)
+      i >>= 1;
+    return i >> 1;
+  }
+
+  size_t next_pre_order(size_t i) const
+  {
+    if (2 * i <= n)
+      return 2 * i;
+    // up until we're a left child with a right sibling, then go over
+    while (i > 1 && ((i & 1) || i + 1 > n))
+      i >>= 1;
+    return i > 1 ? i + 1 : 0;
+  }
+
+  // in a complete tree a node with children has a left child, so the
+  // leftmost node of a subtree is also the first one post order visits
+  size_t first_post_order() const { return n ? leftmost(1) : 0; }
+
+  size_t next_post_order(size_t i) const
+  {
+    if (i == 1)
+      return 0;
+    if (!(i & 1) && i + 1 <= n)
+      return leftmost(i + 1);
+    return i >> 1;
+  }
+
+  std::vector<T> values; // values[0] is unused
+  size_t n;
+};
@@ -0,0 +1,96 @@
+#include <iostream>
+#include <list>
+#include <chrono>
+#include <numeric>
+#include <algorithm>
+using namespace std;
+
+#include "behavioral_iterator_block.h"
+#include "behavioral_iterator_unrolled_list.h"
+#include "behavioral_iterator_array_tree.h"
+
+namespace
+{
+  // consumers: the inner loops have a fixed trip count, which GCC
+  // vectorizes even with the cheap cost model of -O2; the tail of each
+  // block is done one by one. nothing is vectorized without optimization,
+  // and the top-level CMakeLists sets no -O: configure with
+  // -DCMAKE_BUILD_TYPE=Release
+  constexpr size_t lanes = 16;
+
+  long long sum(Block<const int> block)
+  {
+    long long total = 0;
+    size_t i = 0;
+    for (; i + lanes <= block.size; i += lanes)
+    {
+      long long partial = 0;
+      for (size_t j = 0; j < lanes; ++j)
+        partial += block.data[i + j];
+      total += partial;
+    }
+    for (; i < block.size; ++i)
+      total += block.data[i];
+    return total;
+  }
+
+  size_t count_multiples_of_8(Block<const int> block)
+  {
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + lanes <= block.size; i += lanes)
+    {
+      int partial = 0;
+      for (size_t j = 0; j < lanes; ++j)
+        partial += (block.data[i + j] & 7) == 0;
+      count += partial;
+    }
+    for (; i < block.size; ++i)
+      count += (block.data[i] & 7) == 0;
+    return count;
+  }
+
+  template <typename Container> void compare(const char* name, const Container& c)
+  {
+    long long element_sum = 0, block_sum = 0;
+    size_t element_count = 0, block_count = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (auto v : c)
+    {
+      element_sum += v;
+      element_count += (v & 7) == 0;
+    }
+    chrono::duration<double, milli> element_time = chrono::steady_clock::now() - start;
+
+    start = chrono::steady_clock::now();
+    for_each_block(c, [&](Block<const int> block) {
+      block_sum += sum(block);
+      block_count += count_multiples_of_8(block);
+    });
+    chrono::duration<double, milli> block_time = chrono::steady_clock::now() - start;
+
+    cout << name << ": by element " << element_time.count() << " ms, by block "
+      << block_time.count() << " ms"
+      << (element_sum == block_sum && element_count == block_count ? "" : " (RESULTS DIFFER)") << "\n";
+  }
+}
+
+int main_iterator_blocks()
+{
+  const int n = 20000000;
+  UnrolledList<int, 4096> unrolled; // a block per chunk, so bigger chunks
+  list<int> linked;
+  for (int i = 0; i < n; ++i)
+  {
+    unrolled.push_back(i);
+    linked.push_back(i);
+  }
+  ArrayBinaryTree<int> tree{ unrolled.begin(), unrolled.end() };
+
+  cout << n << " ints, sum and count of multiples of 8:\n";
+  compare("unrolled list", unrolled);
+  compare("array tree   ", tree);
+  compare("std::list    ", linked); // no contiguous storage: buffered fallback
+  return 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+// a run of elements that are next to each other in memory; the consumer
+// gets a pointer and a length instead of one element per call, so its
+// inner loop can be vectorized
+template <typename T> struct Block
+{
+  T* data;
+  size_t size;
+
+  T* begin() const { return data; }
+  T* end() const { return data + size; }
+  T& operator[](size_t i) const { return data[i]; }
+};
+
+// block iteration: for_each_block(c, f) calls f(Block<const T>) for runs of
+// elements that together cover c exactly once.
+//  - containers with contiguous storage provide a member
+//    for_each_block(f) and hand out their own memory
+//  - anything else with begin()/end() is read element by element into a
+//    local buffer that is handed out in blocks of `fallback_block` elements
+// blocks follow iteration order unless the container says otherwise
+// (ArrayBinaryTree gives its values in storage order)
+
+constexpr size_t fallback_block = 256;
+
+namespace block_detail
+{
+  template <typename C, typename F>
+  auto dispatch(const C& c, F& f, int) -> decltype(c.for_each_block(f), void())
+  {
+    c.for_each_block(f);
+  }
+
+  template <typename C, typename F>
+  void dispatch(const C& c, F& f, long)
+  {
+    using T = typename std::decay<decltype(*std::begin(c))>::type;
+    T buffer[fallback_block];
+    size_t filled = 0;
+    for (auto& value : c)
+    {
+      buffer[filled++] = value;
+      if (filled == fallback_block)
+      {
+        f(Block<const T>{buffer, filled});
+        filled = 0;
+      }
+    }
+    if (filled)
+      f(Block<const T>{buffer, filled});
+  }
+}
+
+template <typename Container, typename F>
+void for_each_block(const Container& c, F f)
+{
+  block_detail::dispatch(c, f, 0);
+}
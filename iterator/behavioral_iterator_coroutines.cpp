@@ -0,0 +1,164 @@
+// C++20: built only when the compiler has <coroutine> (see CMakeLists.txt)
+#include <iostream>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+using namespace std;
+
+#include "behavioral_iterator_frame_pool.h"
+#include "behavioral_iterator_post_order.h"
+
+namespace
+{
+  // frames from the global heap
+  struct HeapFrame
+  {
+  };
+
+  // a bare-bones generator; Frame is the base of the promise type, so
+  // PooledFrame moves every frame into FramePool
+  template <typename T, typename Frame> class basic_generator
+  {
+  public:
+    struct promise_type : Frame
+    {
+      T current;
+
+      basic_generator get_return_object() { return basic_generator{ handle::from_promise(*this) }; }
+      suspend_always initial_suspend() { return {}; }
+      suspend_always final_suspend() noexcept { return {}; }
+      suspend_always yield_value(T value) { current = value; return {}; }
+      void return_void() {}
+      void unhandled_exception() { terminate(); }
+    };
+
+    using handle = coroutine_handle<promise_type>;
+
+    struct iterator
+    {
+      handle coroutine;
+
+      iterator& operator++()
+      {
+        coroutine.resume();
+        if (coroutine.done()) coroutine = nullptr;
+        return *this;
+      }
+
+      T operator*() const { return coroutine.promise().current; }
+      bool operator!=(const iterator& other) const { return coroutine != other.coroutine; }
+    };
+
+    explicit basic_generator(handle coroutine) : coroutine{ coroutine } {}
+    basic_generator(basic_generator&& other) : coroutine{ other.coroutine } { other.coroutine = nullptr; }
+    basic_generator(const basic_generator&) = delete;
+    ~basic_generator() { if (coroutine) coroutine.destroy(); }
+
+    iterator begin()
+    {
+      coroutine.resume();
+      return iterator{ coroutine.done() ? nullptr : coroutine };
+    }
+
+    iterator end() { return iterator{ nullptr }; }
+
+  private:
+    handle coroutine;
+  };
+
+  template <typename T> using generator = basic_generator<T, HeapFrame>;
+  template <typename T> using pooled_generator = basic_generator<T, PooledFrame>;
+
+  struct TreeNode
+  {
+    int value;
+    TreeNode *left = nullptr, *right = nullptr, *parent = nullptr;
+
+    explicit TreeNode(int value) : value{ value } {}
+
+    TreeNode(int value, TreeNode* left, TreeNode* right) : value{ value }, left{ left }, right{ right }
+    {
+      left->parent = right->parent = this;
+    }
+
+    ~TreeNode()
+    {
+      delete left;
+      delete right;
+    }
+  };
+
+  // perfect tree with 2^levels - 1 nodes
+  TreeNode* perfect_tree(int levels, int& next_value)
+  {
+    if (levels == 1)
+      return new TreeNode{ next_value++ };
+    auto left = perfect_tree(levels - 1, next_value);
+    auto right = perfect_tree(levels - 1, next_value);
+    return new TreeNode{ next_value++, left, right };
+  }
+
+  // one frame per node, and every yield is passed up through the frames
+  // of all the node's ancestors
+  template <typename Generator> Generator post_order(TreeNode* node)
+  {
+    if (node)
+    {
+      for (auto x : post_order<Generator>(node->left))
+        co_yield x;
+      for (auto y : post_order<Generator>(node->right))
+        co_yield y;
+      co_yield node;
+    }
+  }
+
+  template <typename F> double milliseconds(F f)
+  {
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  }
+}
+
+// nested generators with heap frames, the same with FramePool frames, and
+// the parent pointer iterator that needs no frames at all
+int main_iterator_coroutines()
+{
+  int next_value = 0;
+  auto root = perfect_tree(20, next_value);
+
+  long long heap_sum = 0, pooled_sum = 0, stackless_sum = 0;
+  auto heap_time = milliseconds([&] {
+    for (auto node : post_order<generator<TreeNode*>>(root))
+      heap_sum += node->value;
+  });
+
+  // the first pass fills the pool, the second one should run entirely on
+  // recycled frames
+  double pooled_time = 0;
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    FramePool::reset_counters();
+    pooled_sum = 0;
+    pooled_time = milliseconds([&] {
+      for (auto node : post_order<pooled_generator<TreeNode*>>(root))
+        pooled_sum += node->value;
+    });
+    auto& counters = FramePool::counters();
+    cout << "pooled frames, pass " << pass + 1 << ": " << counters.allocations << " frames, "
+      << counters.system_allocations << " from the heap, " << counters.cached << " cached\n";
+  }
+
+  auto stackless_time = milliseconds([&] {
+    for (auto& node : post_order_stackless(root))
+      stackless_sum += node.value;
+  });
+
+  cout << next_value << " nodes in post order: generators " << heap_time
+    << " ms, pooled generators " << pooled_time << " ms, parent pointers " << stackless_time << " ms"
+    << (heap_sum == stackless_sum && pooled_sum == stackless_sum ? "" : " (RESULTS DIFFER)") << "\n";
+
+  FramePool::release();
+  delete root;
+  return 0;
+}
@@ -1,9 +1,13 @@
 ﻿#include <iostream>
 #include <string>
 #include <algorithm>
+#include <vector>
+#include <random>
+#include <chrono>
 using namespace std;
 
 #include <boost/iterator/iterator_facade.hpp>
+#include "behavioral_iterator_unrolled_list.h"
 
 
 struct Node
@@ -66,3 +70,71 @@ int main_0()
   getchar();
   return 0;
 }
+
+namespace
+{
+  template <typename F> double nanoseconds_per_element(size_t elements, F f)
+  {
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / elements;
+  }
+}
+
+int main_iterator_unrolled()
+{
+  const size_t n = 2000000;
+  vector<string> values;
+  for (size_t i = 0; i < n; ++i)
+    values.push_back("item" + to_string(i));
+
+  // Node chain in allocation order, the best case for it
+  vector<Node*> nodes;
+  nodes.reserve(n);
+  auto chain_insert = nanoseconds_per_element(n, [&] {
+    nodes.push_back(new Node{ values[0] });
+    for (size_t i = 1; i < n; ++i)
+      nodes.push_back(new Node{ values[i], nodes.back() });
+  });
+
+  UnrolledList<string> list;
+  auto unrolled_insert = nanoseconds_per_element(n, [&] {
+    for (auto& v : values)
+      list.push_back(v);
+  });
+
+  size_t chain_chars = 0, shuffled_chars = 0, unrolled_chars = 0;
+  auto chain_walk = nanoseconds_per_element(n, [&] {
+    for_each(ListIterator{ nodes.front() }, ListIterator{}, [&](const Node& node) {
+      chain_chars += node.value.size();
+    });
+  });
+
+  // the same nodes relinked in random order, as a long-lived list that
+  // was edited a lot ends up
+  shuffle(nodes.begin(), nodes.end(), mt19937{ 9 });
+  for (size_t i = 0; i + 1 < n; ++i)
+    nodes[i]->next = nodes[i + 1];
+  nodes.back()->next = nullptr;
+  auto shuffled_walk = nanoseconds_per_element(n, [&] {
+    for_each(ListIterator{ nodes.front() }, ListIterator{}, [&](const Node& node) {
+      shuffled_chars += node.value.size();
+    });
+  });
+
+  auto unrolled_walk = nanoseconds_per_element(n, [&] {
+    for_each(list.begin(), list.end(), [&](const string& value) {
+      unrolled_chars += value.size();
+    });
+  });
+
+  cout << n << " strings, ns per element:\n"
+    << "  append:  Node chain " << chain_insert << ", unrolled " << unrolled_insert << "\n"
+    << "  iterate: Node chain " << chain_walk << " (" << shuffled_walk << " relinked at random), unrolled "
+    << unrolled_walk << "\n"
+    << (chain_chars == unrolled_chars && shuffled_chars == unrolled_chars ? "" : "RESULTS DIFFER\n");
+
+  for (auto node : nodes)
+    delete node;
+  return 0;
+}
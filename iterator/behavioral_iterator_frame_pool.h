@@ -0,0 +1,113 @@
+#pragma once
+#include <cstddef>
+#include <new>
+
+// recycles coroutine frames. a recursive generator creates and destroys a
+// frame for every node it visits, always in LIFO order, so a per-thread
+// stack of freed blocks for each size class turns almost every frame
+// allocation into a pop and every free into a push. promise types opt in
+// by deriving from PooledFrame, which gives them the class-level
+// operator new/delete the compiler uses for the frame.
+//
+// frames are rounded up to 64-byte classes up to 4 KB; bigger ones go
+// straight to ::operator new. cached blocks are returned to the system
+// when the thread exits or on release()
+class FramePool
+{
+public:
+  static constexpr size_t granularity = 64;
+  static constexpr size_t class_count = 64;
+
+  // per thread
+  struct Counters
+  {
+    size_t allocations = 0;        // frames handed out
+    size_t system_allocations = 0; // of which had to come from ::operator new
+    size_t deallocations = 0;
+    size_t cached = 0;             // blocks currently on the free lists
+  };
+
+  static void* allocate(size_t size)
+  {
+    auto& pool = local();
+    ++pool.counters.allocations;
+    auto c = size_class(size);
+    if (c < class_count && pool.free[c])
+    {
+      auto block = pool.free[c];
+      pool.free[c] = block->next;
+      --pool.counters.cached;
+      return block;
+    }
+    ++pool.counters.system_allocations;
+    return ::operator new(c < class_count ? (c + 1) * granularity : size);
+  }
+
+  static void deallocate(void* p, size_t size)
+  {
+    auto& pool = local();
+    ++pool.counters.deallocations;
+    auto c = size_class(size);
+    if (c >= class_count)
+    {
+      ::operator delete(p);
+      return;
+    }
+    auto block = static_cast<Block*>(p);
+    block->next = pool.free[c];
+    pool.free[c] = block;
+    ++pool.counters.cached;
+  }
+
+  static const Counters& counters() { return local().counters; }
+  // zeroes the event counts; `cached` keeps describing the free lists
+  static void reset_counters()
+  {
+    auto& c = local().counters;
+    c.allocations = c.system_allocations = c.deallocations = 0;
+  }
+
+  // hands this thread's cached blocks back to the system
+  static void release() { local().release(); }
+
+private:
+  struct Block
+  {
+    Block* next;
+  };
+
+  struct Pool
+  {
+    Block* free[class_count] = {};
+    Counters counters;
+
+    ~Pool() { release(); }
+
+    void release()
+    {
+      for (auto& head : free)
+        while (head)
+        {
+          auto next = head->next;
+          ::operator delete(head);
+          head = next;
+        }
+      counters.cached = 0;
+    }
+  };
+
+  static size_t size_class(size_t size) { return size ? (size - 1) / granularity : 0; }
+
+  static Pool& local()
+  {
+    thread_local Pool pool;
+    return pool;
+  }
+};
+
+// base for promise types whose frames should come from FramePool
+struct PooledFrame
+{
+  static void* operator new(size_t size) { return FramePool::allocate(size); }
+  static void operator delete(void* p, size_t size) { FramePool::deallocate(p, size); }
+};
@@ -0,0 +1,45 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <numeric>
+#include <functional>
+using namespace std;
+
+#include "behavioral_iterator_parallel.h"
+#include "behavioral_iterator_unrolled_list.h"
+#include "behavioral_iterator_array_tree.h"
+
+// usage: main_iterator_parallel(argc, argv) with argv[1] = element count;
+// 10^8 elements need about 1.5 GB for the list, the tree and its input
+int main_iterator_parallel(int argc, char* argv[])
+{
+  size_t n = argc > 1 ? stoull(argv[1]) : 20000000;
+
+  UnrolledList<long long> list;
+  for (size_t i = 0; i < n; ++i)
+    list.push_back(static_cast<long long>(i)); // ascending, as the tree needs
+  ArrayBinaryTree<long long> tree{ list.begin(), list.end() };
+  auto expected = accumulate(list.begin(), list.end(), 0LL);
+
+  auto cores = max(1u, thread::hardware_concurrency());
+  cout << n << " elements, sum " << expected << "\n";
+  for (unsigned threads = 1; ; threads = min(threads * 2, cores))
+  {
+    WorkStealingPool pool{ threads };
+
+    auto start = chrono::steady_clock::now();
+    auto list_sum = parallel_reduce(pool, list, 0LL, plus<long long>{});
+    chrono::duration<double, milli> list_time = chrono::steady_clock::now() - start;
+
+    start = chrono::steady_clock::now();
+    auto tree_sum = parallel_reduce(pool, tree, 0LL, plus<long long>{});
+    chrono::duration<double, milli> tree_time = chrono::steady_clock::now() - start;
+
+    cout << threads << " threads: unrolled list " << list_time.count() << " ms, array tree "
+      << tree_time.count() << " ms"
+      << (list_sum == expected && tree_sum == expected ? "" : " (RESULTS DIFFER)") << "\n";
+    if (threads == cores) break;
+  }
+  return 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "../common/work_stealing_pool.h"
+
+// parallel algorithms for containers that can cut themselves into
+// subranges: c.split(parts) returns consecutive [first, last) iterator
+// pairs that together cover the container in its iteration order
+// (UnrolledList cuts at chunk boundaries, ArrayBinaryTree by rank).
+// the container is cut into a few parts per worker so that stealing can
+// even out parts that turn out slower than others
+
+template <typename Container>
+auto split_for(WorkStealingPool& pool, const Container& c)
+{
+  return c.split(pool.size() * 4);
+}
+
+// f is called from several threads at once
+template <typename Container, typename F>
+void parallel_for_each(WorkStealingPool& pool, const Container& c, F f)
+{
+  auto parts = split_for(pool, c);
+  TaskGroup group{pool};
+  for (auto& part : parts)
+    group.run([&part, &f] { std::for_each(part.first, part.second, f); });
+  group.wait();
+}
+
+// op has to be associative; parts are folded on their own and the partial
+// results combined left to right, so op doesn't have to be commutative
+template <typename Container, typename T, typename Op>
+T parallel_reduce(WorkStealingPool& pool, const Container& c, T init, Op op)
+{
+  struct Partial
+  {
+    T value;
+    bool present;
+  };
+
+  auto parts = split_for(pool, c);
+  std::vector<Partial> partials(parts.size(), Partial{init, false});
+  {
+    TaskGroup group{pool};
+    for (size_t p = 0; p < parts.size(); ++p)
+      group.run([&, p] {
+        auto it = parts[p].first, last = parts[p].second;
+        if (it == last)
+          return;
+        T value = *it;
+        for (++it; it != last; ++it)
+          value = op(value, *it);
+        partials[p] = {value, true};
+      });
+    group.wait();
+  }
+  for (auto& partial : partials)
+    if (partial.present)
+      init = op(init, partial.value);
+  return init;
+}
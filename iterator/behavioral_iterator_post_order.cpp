@@ -0,0 +1,114 @@
+#include <iostream>
+#include <vector>
+#include <utility>
+#include <chrono>
+using namespace std;
+
+#include "behavioral_iterator_post_order.h"
+
+namespace
+{
+  struct TreeNode
+  {
+    int value;
+    TreeNode *left = nullptr, *right = nullptr, *parent = nullptr;
+
+    explicit TreeNode(int value) : value{ value } {}
+
+    TreeNode(int value, TreeNode* left, TreeNode* right) : value{ value }, left{ left }, right{ right }
+    {
+      left->parent = right->parent = this;
+    }
+
+    ~TreeNode()
+    {
+      delete left;
+      delete right;
+    }
+  };
+
+  // perfect tree with 2^levels - 1 nodes, numbered in post order
+  TreeNode* perfect_tree(int levels, int& next_value)
+  {
+    if (levels == 1)
+      return new TreeNode{ next_value++ };
+    auto left = perfect_tree(levels - 1, next_value);
+    auto right = perfect_tree(levels - 1, next_value);
+    return new TreeNode{ next_value++, left, right };
+  }
+
+  template <typename F> void post_order_recursive(TreeNode* node, F& f)
+  {
+    if (!node)
+      return;
+    post_order_recursive(node->left, f);
+    post_order_recursive(node->right, f);
+    f(node);
+  }
+
+  // what an iterator without parent pointers has to carry: the path from
+  // the root, with a flag saying whether the right subtree is done
+  template <typename F> void post_order_explicit_stack(TreeNode* root, F f)
+  {
+    vector<pair<TreeNode*, bool>> path;
+    if (root)
+      path.emplace_back(root, false);
+    while (!path.empty())
+    {
+      auto& top = path.back();
+      auto node = top.first;
+      if (top.second)
+      {
+        f(node);
+        path.pop_back();
+        continue;
+      }
+      top.second = true;
+      if (node->right)
+        path.emplace_back(node->right, false);
+      if (node->left)
+        path.emplace_back(node->left, false);
+    }
+  }
+
+  template <typename F> double milliseconds(F f)
+  {
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  }
+}
+
+// the coroutine version (behavioral_iterator.cpp.txt) allocates a frame
+// per node and resumes a chain of depth frames per yield; the parent
+// pointer version needs neither frames nor a stack
+int main_iterator_post_order()
+{
+  int next_value = 0;
+  auto root = perfect_tree(20, next_value);
+
+  long long recursive_sum = 0, stack_sum = 0, stackless_sum = 0;
+  bool in_order = true;
+  auto recursive_time = milliseconds([&] {
+    auto add = [&](TreeNode* node) { recursive_sum += node->value; };
+    post_order_recursive(root, add);
+  });
+  auto stack_time = milliseconds([&] {
+    post_order_explicit_stack(root, [&](TreeNode* node) { stack_sum += node->value; });
+  });
+  auto stackless_time = milliseconds([&] {
+    int expected = 0;
+    for (auto& node : post_order_stackless(root))
+    {
+      in_order = in_order && node.value == expected++;
+      stackless_sum += node.value;
+    }
+  });
+
+  cout << next_value << " nodes in post order: recursion " << recursive_time
+    << " ms, explicit stack " << stack_time << " ms, parent pointers " << stackless_time << " ms"
+    << (recursive_sum == stackless_sum && stack_sum == stackless_sum && in_order ? "" : " (RESULTS DIFFER)") << "\n";
+
+  delete root;
+  return 0;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+
+// post order without coroutines: the parent pointers lead back up, so
+// the iterator is a single node pointer, increments allocate nothing and
+// cost O(1) amortized (every edge is walked down once and up once).
+//
+// Node is any node type with `left`, `right` and `parent` pointers, such
+// as BinaryTree's Node in behavioral_iterator.cpp.txt
+template <typename Node> struct PostOrderIterator
+{
+  typedef std::forward_iterator_tag iterator_category;
+  typedef Node value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef Node* pointer;
+  typedef Node& reference;
+
+  Node* current;
+
+  explicit PostOrderIterator(Node* current)
+    : current(current)
+  {
+  }
+
+  // the first node post order visits under `n`: go down, left when
+  // there is a left child, right otherwise, until there are no children
+  static Node* first_under(Node* n)
+  {
+    if (n)
+      while (n->left || n->right)
+        n = n->left ? n->left : n->right;
+    return n;
+  }
+
+  bool operator==(const PostOrderIterator& other) const
+  {
+    return current == other.current;
+  }
+
+  bool operator!=(const PostOrderIterator& other) const
+  {
+    return current != other.current;
+  }
+
+  // coming up from a left child, the right subtree is next if there is
+  // one; otherwise (or coming up from the right) the parent is
+  PostOrderIterator& operator++()
+  {
+    Node* p = current->parent;
+    if (p && current == p->left && p->right)
+      current = first_under(p->right);
+    else
+      current = p;
+    return *this;
+  }
+
+  PostOrderIterator operator++(int)
+  {
+    auto old = *this;
+    ++*this;
+    return old;
+  }
+
+  Node& operator*() const { return *current; }
+  Node* operator->() const { return current; }
+};
+
+// traversal object over the subtree under `root`
+template <typename Node> class PostOrderTraversal
+{
+  Node* root;
+public:
+  explicit PostOrderTraversal(Node* root) : root{root} {}
+  PostOrderIterator<Node> begin() const { return PostOrderIterator<Node>{ PostOrderIterator<Node>::first_under(root) }; }
+  PostOrderIterator<Node> end() const { return PostOrderIterator<Node>{ nullptr }; }
+};
+
+template <typename Node> PostOrderTraversal<Node> post_order_stackless(Node* root)
+{
+  return PostOrderTraversal<Node>{ root };
+}
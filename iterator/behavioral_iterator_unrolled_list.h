@@ -0,0 +1,298 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/iterator/iterator_facade.hpp>
+#include "behavioral_iterator_block.h"
+
+// singly linked list that stores up to `capacity` elements per node
+// ("chunk"), so walking it touches one cache line after another instead of
+// taking a pointer hop and a likely cache miss per element. chunks start on
+// a cache line boundary. appending is O(1); inserting in the middle shifts
+// at most one chunk's worth of elements and splits a full chunk in two, so
+// it is O(1) amortized as well
+template <typename T, size_t ChunkBytes = 256>
+class UnrolledList
+{
+  struct Chunk;
+
+public:
+  static constexpr size_t cache_line = 64;
+
+  template <typename V>
+  class Iterator : public boost::iterator_facade<Iterator<V>, V, boost::forward_traversal_tag>
+  {
+  public:
+    Iterator() = default;
+
+    // iterator -> const_iterator
+    template <typename U, typename = std::enable_if_t<std::is_convertible<U*, V*>::value>>
+    Iterator(const Iterator<U>& other) : chunk{other.chunk}, index{other.index} {}
+
+  private:
+    friend class boost::iterator_core_access;
+    friend class UnrolledList;
+    template <typename> friend class Iterator;
+
+    Iterator(Chunk* chunk, uint32_t index) : chunk{chunk}, index{index} {}
+
+    void increment()
+    {
+      if (++index == chunk->count)
+      {
+        chunk = chunk->next;
+        index = 0;
+      }
+    }
+
+    template <typename U> bool equal(const Iterator<U>& other) const
+    {
+      return chunk == other.chunk && index == other.index;
+    }
+
+    V& dereference() const { return chunk->at(index); }
+
+    Chunk* chunk = nullptr;
+    uint32_t index = 0;
+  };
+
+  using iterator = Iterator<T>;
+  using const_iterator = Iterator<const T>;
+
+  UnrolledList() = default;
+  ~UnrolledList() { clear(); }
+
+  UnrolledList(const UnrolledList&) = delete;
+  UnrolledList& operator=(const UnrolledList&) = delete;
+
+  iterator begin() { return {head, 0}; }
+  iterator end() { return {}; }
+  const_iterator begin() const { return {head, 0}; }
+  const_iterator end() const { return {}; }
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  template <typename... Args> T& emplace_back(Args&&... args)
+  {
+    if (!tail || tail->count == Chunk::capacity)
+      link_after(tail, allocate_chunk());
+    ++count;
+    return *new (tail->slot(tail->count++)) T(std::forward<Args>(args)...);
+  }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  // inserts before `position`, returns an iterator to the new element;
+  // other iterators into the same chunk are invalidated
+  iterator insert(const_iterator position, T value)
+  {
+    if (!position.chunk)
+    {
+      emplace_back(std::move(value));
+      return {tail, tail->count - 1};
+    }
+
+    auto chunk = position.chunk;
+    auto index = position.index;
+    if (chunk->count == Chunk::capacity)
+    {
+      // move the upper half into a new chunk right behind this one
+      auto half = static_cast<uint32_t>(Chunk::capacity / 2);
+      auto upper = allocate_chunk();
+      for (auto i = half; i < chunk->count; ++i)
+      {
+        new (upper->slot(upper->count++)) T(std::move(chunk->at(i)));
+        chunk->at(i).~T();
+      }
+      chunk->count = half;
+      link_after(chunk, upper);
+      if (index >= half)
+      {
+        chunk = upper;
+        index -= half;
+      }
+    }
+
+    // shift [index, count) one slot up, from the top
+    if (index == chunk->count)
+      new (chunk->slot(index)) T(std::move(value));
+    else
+    {
+      new (chunk->slot(chunk->count)) T(std::move(chunk->at(chunk->count - 1)));
+      for (auto i = chunk->count - 1; i > index; --i)
+        chunk->at(i) = std::move(chunk->at(i - 1));
+      chunk->at(index) = std::move(value);
+    }
+    ++chunk->count;
+    ++count;
+    return {chunk, index};
+  }
+
+  // removes the element at `position`, returns an iterator to the element
+  // after it. the rest of the chunk shifts down; a chunk left empty takes
+  // over the next chunk's elements, or is unlinked if it is the tail (a walk
+  // from the head to find its predecessor). iterators into the chunk and
+  // the one after it are invalidated
+  iterator erase(const_iterator position)
+  {
+    auto chunk = position.chunk;
+    auto index = position.index;
+    for (auto i = index; i + 1 < chunk->count; ++i)
+      chunk->at(i) = std::move(chunk->at(i + 1));
+    chunk->at(--chunk->count).~T();
+    --count;
+
+    if (chunk->count == 0)
+    {
+      if (auto next = chunk->next)
+      {
+        for (uint32_t i = 0; i < next->count; ++i)
+        {
+          new (chunk->slot(i)) T(std::move(next->at(i)));
+          next->at(i).~T();
+        }
+        chunk->count = next->count;
+        chunk->next = next->next;
+        if (tail == next)
+          tail = chunk;
+        ::operator delete(next->allocation);
+        return {chunk, 0};
+      }
+      unlink_tail();
+      return end();
+    }
+    if (index == chunk->count)
+      return {chunk->next, 0};
+    return {chunk, index};
+  }
+
+  // one block per chunk, in order
+  template <typename F> void for_each_block(F&& f) const
+  {
+    for (auto chunk = head; chunk; chunk = chunk->next)
+      f(Block<const T>{&chunk->at(0), chunk->count});
+  }
+
+  // cuts the list into at most `parts` consecutive subranges of about the
+  // same number of elements, at chunk boundaries; costs one walk over the
+  // chunks, not the elements
+  std::vector<std::pair<const_iterator, const_iterator>> split(size_t parts) const
+  {
+    std::vector<std::pair<const_iterator, const_iterator>> ranges;
+    if (!head || parts == 0)
+      return ranges;
+    auto target = (count + parts - 1) / parts;
+    auto first = head;
+    size_t taken = 0;
+    for (auto chunk = head; chunk; chunk = chunk->next)
+    {
+      taken += chunk->count;
+      if (taken >= target || !chunk->next)
+      {
+        ranges.emplace_back(const_iterator{first, 0}, const_iterator{chunk->next, 0});
+        first = chunk->next;
+        taken = 0;
+      }
+    }
+    return ranges;
+  }
+
+  void clear()
+  {
+    for (auto chunk = head; chunk; )
+    {
+      auto next = chunk->next;
+      for (uint32_t i = 0; i < chunk->count; ++i)
+        chunk->at(i).~T();
+      ::operator delete(chunk->allocation);
+      chunk = next;
+    }
+    head = tail = nullptr;
+    count = 0;
+  }
+
+private:
+  using Slot = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+  // Chunk's fields with a single slot, so the compiler works out where the
+  // slots start and how the chunk is aligned, padding included
+  struct ChunkLayout
+  {
+    Chunk* next;
+    void* allocation;
+    uint32_t count;
+    Slot slots[1];
+  };
+
+  struct Chunk
+  {
+    Chunk* next = nullptr;
+    void* allocation;
+    uint32_t count = 0;
+
+    static constexpr size_t header = offsetof(ChunkLayout, slots);
+    // sizeof(Chunk) is a multiple of its alignment, so only whole
+    // multiples of it of the budget are usable
+    static constexpr size_t usable = ChunkBytes / alignof(ChunkLayout) * alignof(ChunkLayout);
+    static constexpr size_t capacity = usable >= header + sizeof(T) ? (usable - header) / sizeof(T) : 1;
+
+    Slot slots[capacity];
+
+    void* slot(uint32_t i) { return &slots[i]; }
+    T& at(uint32_t i) { return *reinterpret_cast<T*>(&slots[i]); }
+  };
+
+  static_assert(offsetof(Chunk, slots) == Chunk::header, "ChunkLayout has to match Chunk");
+  // a T bigger than the whole budget still gets one slot per chunk
+  static_assert(sizeof(Chunk) <= ChunkBytes || Chunk::capacity == 1, "chunk exceeds ChunkBytes");
+
+  // plain operator new only guarantees alignof(max_align_t) before C++17,
+  // so chunks are placed on a cache line by hand
+  static Chunk* allocate_chunk()
+  {
+    size_t space = sizeof(Chunk) + cache_line;
+    auto allocation = ::operator new(space);
+    void* p = allocation;
+    std::align(cache_line, sizeof(Chunk), p, space);
+    auto chunk = new (p) Chunk;
+    chunk->allocation = allocation;
+    return chunk;
+  }
+
+  void link_after(Chunk* chunk, Chunk* added)
+  {
+    if (!chunk)
+    {
+      head = tail = added;
+      return;
+    }
+    added->next = chunk->next;
+    chunk->next = added;
+    if (tail == chunk)
+      tail = added;
+  }
+
+  // frees the (empty) tail chunk
+  void unlink_tail()
+  {
+    Chunk* previous = nullptr;
+    if (head != tail)
+      for (previous = head; previous->next != tail; previous = previous->next) {}
+    ::operator delete(tail->allocation);
+    tail = previous;
+    if (previous)
+      previous->next = nullptr;
+    else
+      head = nullptr;
+  }
+
+  Chunk *head = nullptr, *tail = nullptr;
+  size_t count = 0;
+};
@@ -0,0 +1,172 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "../common/work_stealing_pool.h"
+#include "behavioral_state_table.h"
+
+// smallest power of two not below n, and the log2 of a power of two; plain
+// loops so they stay constexpr on every compiler (C++14)
+constexpr size_t next_power_of_two(size_t n)
+{
+  size_t p = 1;
+  while (p < n)
+    p <<= 1;
+  return p;
+}
+
+constexpr int log2_of_power_of_two(size_t n)
+{
+  int k = 0;
+  while (n > 1)
+  {
+    n >>= 1;
+    ++k;
+  }
+  return k;
+}
+
+// many independent machines sharing one TransitionTable. every machine's
+// state is one byte in a flat array, and a tick applies a column of
+// triggers (one byte per machine) with a table lookup per machine; an
+// undefined transition leaves that machine where it is
+//
+// with AVX2 a tick handles 32 machines per iteration: when the table has
+// at most 16 triggers and 16 states each state's row sits in a register
+// and the lookup is a byte shuffle, otherwise it is a 32-bit gather
+template <typename State, typename Trigger, size_t StateCount, size_t TriggerCount>
+class MachineBatch
+{
+  static_assert(StateCount <= 256 && TriggerCount <= 256, "states and triggers are stored as bytes");
+
+public:
+  using Table = TransitionTable<State, Trigger, StateCount, TriggerCount>;
+
+  MachineBatch(const Table& table, size_t machines, State initial)
+    : states(machines, static_cast<uint8_t>(initial))
+  {
+    for (size_t s = 0; s < StateCount; ++s)
+      for (size_t t = 0; t < stride; ++t)
+      {
+        auto to = t < TriggerCount ? table(static_cast<State>(s), static_cast<Trigger>(t)) : Table::undefined;
+        next[s * stride + t] = to == Table::undefined ? s : static_cast<size_t>(to);
+      }
+  }
+
+  size_t size() const { return states.size(); }
+  State state(size_t machine) const { return static_cast<State>(states[machine]); }
+  const uint8_t* data() const { return states.data(); }
+
+  // one tick: machine i receives triggers[i], which must be below TriggerCount
+  void step(const uint8_t* triggers)
+  {
+    step_range(triggers, 0, states.size());
+  }
+
+  // the same tick split into slices of `grain` machines across the pool
+  void step(const uint8_t* triggers, WorkStealingPool& pool, size_t grain = 1 << 18)
+  {
+    TaskGroup group{ pool };
+    for (size_t first = 0; first < states.size(); first += grain)
+    {
+      auto last = std::min(first + grain, states.size());
+      group.run([this, triggers, first, last] { step_range(triggers, first, last); });
+    }
+    group.wait();
+  }
+
+  // number of machines in each state
+  std::array<size_t, StateCount> counts() const
+  {
+    std::array<size_t, StateCount> result{};
+    for (auto s : states)
+      ++result[s];
+    return result;
+  }
+
+private:
+  // row length in the lookup table, a power of two so the index is a shift
+  static constexpr size_t stride = next_power_of_two(TriggerCount);
+  static constexpr int shift = log2_of_power_of_two(stride);
+
+  void step_range(const uint8_t* triggers, size_t first, size_t last)
+  {
+    auto s = states.data();
+    auto i = first;
+#ifdef __AVX2__
+    i = step_simd(s, triggers, first, last, std::integral_constant<bool, (StateCount <= 16 && stride <= 16)>{});
+#endif
+    for (; i < last; ++i)
+      s[i] = static_cast<uint8_t>(next[(s[i] << shift) | triggers[i]]);
+  }
+
+#ifdef __AVX2__
+  // per state, shuffle the whole trigger vector through that state's row
+  // and keep the lanes whose machine is in that state
+  size_t step_simd(uint8_t* s, const uint8_t* triggers, size_t i, size_t last, std::true_type)
+  {
+    alignas(16) uint8_t row_bytes[16] = {};
+    __m256i rows[StateCount];
+    for (size_t k = 0; k < StateCount; ++k)
+    {
+      for (size_t t = 0; t < stride; ++t)
+        row_bytes[t] = static_cast<uint8_t>(next[k * stride + t]);
+      rows[k] = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(row_bytes)));
+    }
+
+    for (; i + 32 <= last; i += 32)
+    {
+      auto current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+      auto trigger = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(triggers + i));
+      auto result = _mm256_setzero_si256();
+      for (size_t k = 0; k < StateCount; ++k)
+      {
+        auto in_state = _mm256_cmpeq_epi8(current, _mm256_set1_epi8(static_cast<char>(k)));
+        result = _mm256_or_si256(result, _mm256_and_si256(in_state, _mm256_shuffle_epi8(rows[k], trigger)));
+      }
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(s + i), result);
+    }
+    return i;
+  }
+
+  // widen 8 states and 8 triggers to 32 bits, gather, and pack 32 results
+  // back to bytes (the packs work per 128-bit lane, hence the permute)
+  size_t step_simd(uint8_t* s, const uint8_t* triggers, size_t i, size_t last, std::false_type)
+  {
+    const auto order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    for (; i + 32 <= last; i += 32)
+    {
+      __m256i gathered[4];
+      for (int k = 0; k < 4; ++k)
+      {
+        auto current = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + i + 8 * k)));
+        auto trigger = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(triggers + i + 8 * k)));
+        auto index = _mm256_or_si256(_mm256_slli_epi32(current, shift), trigger);
+        gathered[k] = _mm256_i32gather_epi32(next, index, 4);
+      }
+      auto low = _mm256_packus_epi32(gathered[0], gathered[1]);
+      auto high = _mm256_packus_epi32(gathered[2], gathered[3]);
+      auto bytes = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(low, high), order);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(s + i), bytes);
+    }
+    return i;
+  }
+#endif
+
+  std::vector<uint8_t> states;
+  int next[StateCount * stride]; // int so the gather can read it directly
+};
+
+template <typename State, typename Trigger, size_t StateCount, size_t TriggerCount>
+constexpr size_t MachineBatch<State, Trigger, StateCount, TriggerCount>::stride;
+
+template <typename State, typename Trigger, size_t StateCount, size_t TriggerCount>
+constexpr int MachineBatch<State, Trigger, StateCount, TriggerCount>::shift;
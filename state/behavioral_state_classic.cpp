@@ -1,26 +1,26 @@
 ﻿#include <iostream>
 #include <string>
+#include <chrono>
 using namespace std;
 
 class LightSwitch;
 
+// states carry no data, so each one is a single shared instance and a
+// transition is just a pointer swap: no allocation, nothing to delete
 struct State
 {
-  virtual void on(LightSwitch *ls)
-  {
-    cout << "Light is already on\n";
-  }
-  virtual void off(LightSwitch *ls)
-  {
-    cout << "Light is already off\n";
-  }
+  virtual ~State() = default;
+
+  virtual void on(LightSwitch *ls);
+  virtual void off(LightSwitch *ls);
 };
 
 struct OnState : State
 {
-  OnState()
+  static State* instance()
   {
-    cout << "Light turned on\n";
+    static OnState state;
+    return &state;
   }
 
   void off(LightSwitch* ls) override;
@@ -28,9 +28,10 @@ struct OnState : State
 
 struct OffState : State
 {
-  OffState()
+  static State* instance()
   {
-    cout << "Light turned off\n";
+    static OffState state;
+    return &state;
   }
 
   void on(LightSwitch* ls) override;
@@ -39,31 +40,47 @@ struct OffState : State
 class LightSwitch
 {
   State *state;
+  ostream* log; // nullptr keeps transitions silent
 public:
-  LightSwitch()
+  explicit LightSwitch(ostream* log = &cout) : state{ OffState::instance() }, log{ log }
   {
-    state = new OffState();
+    say("Light turned off\n");
   }
   void set_state(State* state)
   {
     this->state = state;
   }
+  void say(const char* message)
+  {
+    if (log) *log << message;
+  }
+  bool is_on() const { return state == OnState::instance(); }
   void on() { state->on(this); }
   void off() { state->off(this); }
 };
 
+void State::on(LightSwitch* ls)
+{
+  ls->say("Light is already on\n");
+}
+
+void State::off(LightSwitch* ls)
+{
+  ls->say("Light is already off\n");
+}
+
 void OnState::off(LightSwitch* ls)
 {
-  cout << "Switching light off...\n";
-  ls->set_state(new OffState());
-  delete this; //warning: delete called on non-final 'OnState' that has virtual functions but non-virtual destructor [-Wdelete-non-virtual-dtor]
+  ls->say("Switching light off...\n");
+  ls->set_state(OffState::instance());
+  ls->say("Light turned off\n");
 }
 
 void OffState::on(LightSwitch* ls)
 {
-  cout << "Switching light on...\n";
-  ls->set_state(new OnState());
-  delete this;
+  ls->say("Switching light on...\n");
+  ls->set_state(OnState::instance());
+  ls->say("Light turned on\n");
 }
 
 void main_3()
@@ -73,4 +90,24 @@ void main_3()
   ls.off();
   ls.off();
   getchar();
-}
\ No newline at end of file
+}
+
+int main_state_flyweight()
+{
+  const long transitions = 100000000;
+  LightSwitch ls{ nullptr };
+  long lit = 0;
+
+  auto start = chrono::steady_clock::now();
+  for (long i = 0; i < transitions; ++i)
+  {
+    if (i & 1) ls.off();
+    else ls.on();
+    lit += ls.is_on();
+  }
+  chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+  cout << transitions << " transitions in " << elapsed.count() * 1000 << " ms ("
+    << transitions / elapsed.count() / 1e6 << " M/s), on after " << lit << "\n";
+  return 0;
+}
@@ -2,17 +2,30 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <chrono>
+#include <random>
+#include <thread>
 using namespace std;
 
+#include <boost/msm/back/state_machine.hpp>
+#include <boost/msm/front/state_machine_def.hpp>
+#include <boost/msm/front/functor_row.hpp>
+
+#include "behavioral_state_batch.h"
+#include "behavioral_state_table.h"
+
 enum class State
 {
   OffHook,
   Connecting,
   Connected,
   OnHold,
-  OnHook
+  OnHook,
+  count // keep last
 };
 
+constexpr size_t state_count = static_cast<size_t>(State::count);
+
 inline ostream& operator<<(ostream& os, const State& s)
 {
   switch (s)
@@ -32,6 +45,7 @@ inline ostream& operator<<(ostream& os, const State& s)
   case State::OnHook:
     os << "on the hook";
     break;
+  default: break;
   }
   return os;
 }
@@ -44,9 +58,12 @@ enum class Trigger
   PlacedOnHold,
   TakenOffHold,
   LeftMessage,
-  StopUsingPhone
+  StopUsingPhone,
+  count // keep last
 };
 
+constexpr size_t trigger_count = static_cast<size_t>(Trigger::count);
+
 inline ostream& operator<<(ostream& os, const Trigger& t)
 {
   switch (t)
@@ -77,55 +94,64 @@ inline ostream& operator<<(ostream& os, const Trigger& t)
   return os;
 }
 
-int main_f(char* argv[])
+namespace
 {
-  map<State, vector<pair<Trigger, State>>> rules;
+  // the phone's rules, compiled into a dense table; reads like the
+  // rules[state] = { {trigger, state}, ... } blocks it replaces
+  constexpr Rule<State, Trigger> phone_rules[] = {
+    { State::OffHook,    Trigger::CallDialed,     State::Connecting },
+    { State::OffHook,    Trigger::StopUsingPhone, State::OnHook },
 
-  rules[State::OffHook] = {
-    {Trigger::CallDialed, State::Connecting},
-    {Trigger::StopUsingPhone, State::OnHook}
-  };
+    { State::Connecting, Trigger::HungUp,         State::OffHook },
+    { State::Connecting, Trigger::CallConnected,  State::Connected },
 
-  rules[State::Connecting] = {
-    {Trigger::HungUp, State::OffHook},
-    {Trigger::CallConnected, State::Connected}
-  };
+    { State::Connected,  Trigger::LeftMessage,    State::OffHook },
+    { State::Connected,  Trigger::HungUp,         State::OffHook },
+    { State::Connected,  Trigger::PlacedOnHold,   State::OnHold },
 
-  rules[State::Connected] = {
-    {Trigger::LeftMessage, State::OffHook},
-    {Trigger::HungUp, State::OffHook},
-    {Trigger::PlacedOnHold, State::OnHold}
+    { State::OnHold,     Trigger::TakenOffHold,   State::Connected },
+    { State::OnHold,     Trigger::HungUp,         State::OffHook }
   };
 
-  rules[State::OnHold] = {
-    {Trigger::TakenOffHold, State::Connected},
-    {Trigger::HungUp, State::OffHook}
-  };
+  using PhoneTable = TransitionTable<State, Trigger, state_count, trigger_count>;
+  constexpr PhoneTable phone_table{ phone_rules };
+
+  static_assert(phone_table(State::OnHold, Trigger::TakenOffHold) == State::Connected, "");
+  static_assert(!phone_table.defined(State::OnHook, Trigger::CallDialed), "");
+}
 
+int main_f(char* argv[])
+{
   State currentState{ State::OffHook },
         exitState{ State::OnHook };
 
+  vector<Trigger> options;
   while (true)
   {
     cout << "The phone is currently " << currentState << endl;
   select_trigger:
     cout << "Select a trigger:" << "\n";
 
+    options.clear();
+    for (size_t t = 0; t < trigger_count; ++t)
+      if (phone_table.defined(currentState, static_cast<Trigger>(t)))
+        options.push_back(static_cast<Trigger>(t));
+
     int i = 0;
-    for (auto item : rules[currentState])
+    for (auto item : options)
     {
-      cout << i++ << ". " << item.first << "\n";
+      cout << i++ << ". " << item << "\n";
     }
 
     int input;
     cin >> input;
-    if (input < 0 || (input+1) > rules[currentState].size())
+    if (input < 0 || input >= static_cast<int>(options.size()))
     {
       cout << "Incorrect option. Please try again." << "\n";
       goto select_trigger;
     }
 
-    currentState = rules[currentState][input].second;
+    currentState = phone_table(currentState, options[input]);
     if (currentState == exitState) break;
   }
 
@@ -135,3 +161,196 @@ int main_f(char* argv[])
   getchar();
   return 0;
 }
+
+namespace
+{
+  // the original map-based rules, kept as the benchmark baseline
+  map<State, vector<pair<Trigger, State>>> phone_rule_map()
+  {
+    map<State, vector<pair<Trigger, State>>> rules;
+
+    rules[State::OffHook] = {
+      {Trigger::CallDialed, State::Connecting},
+      {Trigger::StopUsingPhone, State::OnHook}
+    };
+
+    rules[State::Connecting] = {
+      {Trigger::HungUp, State::OffHook},
+      {Trigger::CallConnected, State::Connected}
+    };
+
+    rules[State::Connected] = {
+      {Trigger::LeftMessage, State::OffHook},
+      {Trigger::HungUp, State::OffHook},
+      {Trigger::PlacedOnHold, State::OnHold}
+    };
+
+    rules[State::OnHold] = {
+      {Trigger::TakenOffHold, State::Connected},
+      {Trigger::HungUp, State::OffHook}
+    };
+
+    return rules;
+  }
+
+  // the same rules as a boost::msm machine
+  namespace phone_msm
+  {
+    using namespace boost::msm::front;
+
+    struct CallDialed {};
+    struct HungUp {};
+    struct CallConnected {};
+    struct PlacedOnHold {};
+    struct TakenOffHold {};
+    struct LeftMessage {};
+    struct StopUsingPhone {};
+
+    struct Phone : state_machine_def<Phone>
+    {
+      long rejected = 0;
+
+      struct OffHook : state<> {};
+      struct Connecting : state<> {};
+      struct Connected : state<> {};
+      struct OnHold : state<> {};
+      struct OnHook : state<> {};
+
+      struct transition_table : boost::mpl::vector<
+        Row<OffHook, CallDialed, Connecting>,
+        Row<OffHook, StopUsingPhone, OnHook>,
+        Row<Connecting, HungUp, OffHook>,
+        Row<Connecting, CallConnected, Connected>,
+        Row<Connected, LeftMessage, OffHook>,
+        Row<Connected, HungUp, OffHook>,
+        Row<Connected, PlacedOnHold, OnHold>,
+        Row<OnHold, TakenOffHold, Connected>,
+        Row<OnHold, HungUp, OffHook>
+      > {};
+
+      typedef OffHook initial_state;
+
+      template <class FSM, class Event>
+      void no_transition(Event const&, FSM&, int)
+      {
+        ++rejected;
+      }
+    };
+
+    using Machine = boost::msm::back::state_machine<Phone>;
+
+    void fire(Machine& phone, Trigger trigger)
+    {
+      switch (trigger)
+      {
+      case Trigger::CallDialed: phone.process_event(CallDialed{}); break;
+      case Trigger::HungUp: phone.process_event(HungUp{}); break;
+      case Trigger::CallConnected: phone.process_event(CallConnected{}); break;
+      case Trigger::PlacedOnHold: phone.process_event(PlacedOnHold{}); break;
+      case Trigger::TakenOffHold: phone.process_event(TakenOffHold{}); break;
+      case Trigger::LeftMessage: phone.process_event(LeftMessage{}); break;
+      case Trigger::StopUsingPhone: phone.process_event(StopUsingPhone{}); break;
+      case Trigger::count: break;
+      }
+    }
+  }
+
+  template <typename Step>
+  void time_steps(const char* name, const vector<Trigger>& triggers, long steps, Step step)
+  {
+    long rejected = 0;
+    auto start = chrono::steady_clock::now();
+    for (long i = 0; i < steps; ++i)
+      rejected += !step(triggers[i & (triggers.size() - 1)]);
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << name << ": " << steps / elapsed.count() / 1e6 << " M steps/s, "
+      << rejected << " undefined transitions\n";
+  }
+}
+
+// random triggers against the three implementations; undefined
+// transitions leave the state alone. the stream never hangs the phone up
+// for good (StopUsingPhone leads to a state with no way out)
+int main_state_table()
+{
+  const long steps = 20000000;
+  mt19937 rng{ 5 };
+  uniform_int_distribution<int> trigger(0, static_cast<int>(Trigger::LeftMessage));
+  vector<Trigger> triggers(4096);
+  for (auto& t : triggers)
+    t = static_cast<Trigger>(trigger(rng));
+
+  auto rules = phone_rule_map();
+  auto state = State::OffHook;
+  time_steps("std::map", triggers, steps, [&](Trigger t) {
+    for (auto& item : rules[state])
+      if (item.first == t)
+      {
+        state = item.second;
+        return true;
+      }
+    return false;
+  });
+
+  state = State::OffHook;
+  time_steps("constexpr table", triggers, steps, [&](Trigger t) {
+    auto next = phone_table(state, t);
+    if (next == PhoneTable::undefined)
+      return false;
+    state = next;
+    return true;
+  });
+
+  phone_msm::Machine phone;
+  phone.start();
+  time_steps("boost::msm", triggers, steps, [&](Trigger t) {
+    auto before = phone.rejected;
+    phone_msm::fire(phone, t);
+    return phone.rejected == before;
+  });
+
+  return 0;
+}
+
+// millions of phones stepped together: each tick gives every phone its
+// own trigger from one of a few pregenerated columns
+int main_state_batch()
+{
+  const size_t phones = 1 << 22;
+  const int ticks = 100, columns = 8;
+
+  mt19937 rng{ 11 };
+  uniform_int_distribution<int> trigger(0, static_cast<int>(Trigger::LeftMessage));
+  vector<uint8_t> triggers(phones * columns);
+  for (auto& t : triggers)
+    t = static_cast<uint8_t>(trigger(rng));
+
+  auto report = [&](const char* name, const MachineBatch<State, Trigger, state_count, trigger_count>& batch, double seconds) {
+    cout << name << ": " << double(phones) * ticks / seconds / 1e9 << " G transitions/s;";
+    auto counts = batch.counts();
+    for (size_t s = 0; s < state_count; ++s)
+      cout << " " << static_cast<State>(s) << " " << counts[s];
+    cout << "\n";
+  };
+
+  {
+    MachineBatch<State, Trigger, state_count, trigger_count> batch{ phone_table, phones, State::OffHook };
+    auto start = chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks; ++tick)
+      batch.step(&triggers[tick % columns * phones]);
+    report("1 thread", batch, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+  }
+
+  auto cores = max(1u, thread::hardware_concurrency());
+  if (cores > 1)
+  {
+    WorkStealingPool pool{ cores };
+    MachineBatch<State, Trigger, state_count, trigger_count> batch{ phone_table, phones, State::OffHook };
+    auto start = chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks; ++tick)
+      batch.step(&triggers[tick % columns * phones], pool);
+    cout << cores << " ";
+    report("threads", batch, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+  }
+  return 0;
+}
@@ -1,6 +1,8 @@
 ﻿#include <iostream>
 #include <string>
 #include <vector>
+#include <chrono>
+#include <random>
 using namespace std;
 
 // back-end
@@ -10,6 +12,8 @@ using namespace std;
 #include <boost/msm/front/state_machine_def.hpp>
 #include <boost/msm/front/functor_row.hpp>
 
+#include "behavioral_state_runtime.h"
+
 namespace msm = boost::msm;
 namespace mpl = boost::mpl;
 using namespace msm::front;
@@ -119,3 +123,140 @@ int main_State()
   getchar();
   return 0;
 }
+
+namespace
+{
+  // a phone session for the runtime. Connected is a nested machine (talking
+  // or on hold) and hanging up leaves it from either substate. a hold
+  // requested while the call is still connecting is deferred until the
+  // call is up. unhandled events are counted instead of printed
+  struct SessionMachine : state_machine_def<SessionMachine>
+  {
+    long unhandled = 0;
+    long calls = 0, holds = 0;
+
+    struct Connected_ : state_machine_def<Connected_>
+    {
+      struct Talking : state<> {};
+      struct OnHold : state<>
+      {
+        template <class Event, class FSM>
+        void on_entry(Event const&, FSM& fsm)
+        {
+          ++fsm.holds;
+        }
+      };
+
+      long holds = 0;
+
+      struct transition_table : mpl::vector<
+        Row<Talking, PlacedOnHold, OnHold>,
+        Row<OnHold, TakenOffHold, Talking>
+      > {};
+
+      typedef Talking initial_state;
+
+      // the enclosing machine gets the event next
+      template <class FSM, class Event>
+      void no_transition(Event const&, FSM&, int) {}
+    };
+    using Connected = msm::back::state_machine<Connected_>;
+
+    struct OffHook : state<> {};
+    struct Connecting : state<>
+    {
+      typedef mpl::vector<PlacedOnHold> deferred_events;
+    };
+
+    struct CountCall
+    {
+      template <class EVT, class FSM, class SourceState, class TargetState>
+      void operator()(EVT const&, FSM& fsm, SourceState&, TargetState&)
+      {
+        ++fsm.calls;
+      }
+    };
+
+    struct transition_table : mpl::vector<
+      Row<OffHook, CallDialed, Connecting>,
+      Row<Connecting, CallConnected, Connected, CountCall>,
+      Row<Connecting, HungUp, OffHook>,
+      Row<Connected, HungUp, OffHook>,
+      Row<Connected, LeftMessage, OffHook>
+    > {};
+
+    typedef OffHook initial_state;
+
+    template <class FSM, class Event>
+    void no_transition(Event const&, FSM&, int)
+    {
+      ++unhandled;
+    }
+  };
+
+  using Session = msm::back::state_machine<SessionMachine>;
+  using SessionEvent = boost::variant<CallDialed, HungUp, CallConnected,
+    PlacedOnHold, TakenOffHold, LeftMessage>;
+}
+
+// bursts of random events for thousands of sessions, posted from the main
+// thread and processed on a small pool
+int main_state_runtime()
+{
+  const size_t sessions = 10000;
+  const int bursts = 50, burst_length = 16;
+
+  auto threads = min(4u, max(1u, thread::hardware_concurrency()));
+  WorkStealingPool pool{ threads };
+  MachineRuntime<Session, SessionEvent> runtime{ pool };
+  for (size_t i = 0; i < sessions; ++i)
+    runtime.add();
+
+  mt19937 rng{ 3 };
+  uniform_int_distribution<int> kind(0, 5);
+  auto make_event = [](int k) -> SessionEvent {
+    switch (k)
+    {
+    case 0: return CallDialed{};
+    case 1: return HungUp{};
+    case 2: return CallConnected{};
+    case 3: return PlacedOnHold{};
+    case 4: return TakenOffHold{};
+    default: return LeftMessage{};
+    }
+  };
+
+  long posted = 0, retries = 0;
+  auto start = chrono::steady_clock::now();
+  for (int burst = 0; burst < bursts; ++burst)
+    for (size_t id = 0; id < sessions; ++id)
+      for (int i = 0; i < burst_length; ++i)
+      {
+        auto event = make_event(kind(rng));
+        // a full queue means the session is behind: help drain, then retry
+        while (!runtime.post(id, event))
+        {
+          ++retries;
+          if (!pool.try_run_one())
+            this_thread::yield();
+        }
+        ++posted;
+      }
+  runtime.wait_idle();
+  chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+  long unhandled = 0, calls = 0, holds = 0;
+  for (size_t id = 0; id < sessions; ++id)
+  {
+    auto& session = runtime.machine(id);
+    unhandled += session.unhandled;
+    calls += session.calls;
+    holds += session.get_state<SessionMachine::Connected&>().holds;
+  }
+
+  cout << sessions << " sessions on " << threads << " threads: " << posted << " events in "
+    << elapsed.count() * 1000 << " ms (" << posted / elapsed.count() / 1e6 << " M events/s), "
+    << retries << " retries on full queues\n"
+    << calls << " calls connected, " << holds << " holds, " << unhandled << " events unhandled\n";
+  return 0;
+}
@@ -0,0 +1,174 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/variant.hpp>
+
+#include "../common/work_stealing_pool.h"
+
+// bounded lock-free queue for any number of producers and one consumer.
+// every slot carries a sequence number that says whose turn it is: a
+// producer claims a position with a CAS on `tail` and publishes the slot
+// by bumping its sequence, the consumer takes slots in order
+template <typename T, size_t Capacity> class EventQueue
+{
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+  EventQueue()
+  {
+    for (size_t i = 0; i < Capacity; ++i)
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  // false when the queue is full
+  bool push(T value)
+  {
+    auto position = tail.load(std::memory_order_relaxed);
+    while (true)
+    {
+      auto& slot = slots[position & (Capacity - 1)];
+      auto sequence = slot.sequence.load(std::memory_order_acquire);
+      auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+      if (difference == 0)
+      {
+        if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+        {
+          slot.value = std::move(value);
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (difference < 0)
+        return false;
+      else
+        position = tail.load(std::memory_order_relaxed);
+    }
+  }
+
+  // consumer only; false when nothing has been published yet
+  bool pop(T& value)
+  {
+    auto& slot = slots[head & (Capacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+      return false;
+    value = std::move(slot.value);
+    slot.sequence.store(head + Capacity, std::memory_order_release);
+    ++head;
+    return true;
+  }
+
+private:
+  struct Slot
+  {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  Slot slots[Capacity];
+  std::atomic<size_t> tail{0};
+  char gap[64]; // keeps producers' tail and the consumer's head on different cache lines
+  size_t head = 0;
+};
+
+// run-to-completion runtime for boost::msm machines: each machine gets an
+// inbound EventQueue, and a machine with queued events is scheduled as a
+// task on a WorkStealingPool that processes up to `budget` of them and
+// reschedules itself if more arrived. a machine is never run by two
+// workers at once, so process_event needs no locking, and thousands of
+// machines share the pool's few threads.
+//
+// Event is a boost::variant of the machine's event types. deferral and
+// nested states are left to msm itself (deferred_events, submachines)
+template <typename Machine, typename Event, size_t QueueCapacity = 64>
+class MachineRuntime
+{
+public:
+  using Id = size_t;
+
+  explicit MachineRuntime(WorkStealingPool& pool, size_t budget = 32) : pool{pool}, budget{budget} {}
+
+  ~MachineRuntime() { wait_idle(); }
+
+  MachineRuntime(const MachineRuntime&) = delete;
+  MachineRuntime& operator=(const MachineRuntime&) = delete;
+
+  // not thread-safe: add every machine before posting events
+  template <typename... Args> Id add(Args&&... args)
+  {
+    sessions.emplace_back(new Session(std::forward<Args>(args)...));
+    sessions.back()->machine.start();
+    return sessions.size() - 1;
+  }
+
+  size_t size() const { return sessions.size(); }
+
+  // only while the runtime is idle (see wait_idle)
+  Machine& machine(Id id) { return sessions[id]->machine; }
+
+  // callable from any thread. false if the machine's queue is full; the
+  // event is dropped and the caller decides whether to retry or shed load
+  bool post(Id id, Event event)
+  {
+    auto& session = *sessions[id];
+    if (!session.queue.push(std::move(event)))
+      return false;
+    // the event is counted after it is queued, so a running drain may
+    // consume it first and briefly take the count below zero; whoever
+    // moves the count up from zero owns scheduling the machine
+    if (session.pending.fetch_add(1, std::memory_order_acq_rel) == 0)
+      schedule(session);
+    return true;
+  }
+
+  // blocks until every posted event has been processed, running queued
+  // tasks on the calling thread meanwhile
+  void wait_idle()
+  {
+    while (scheduled.load(std::memory_order_acquire) != 0)
+      if (!pool.try_run_one())
+        std::this_thread::yield();
+  }
+
+private:
+  struct Session
+  {
+    template <typename... Args> explicit Session(Args&&... args) : machine(std::forward<Args>(args)...) {}
+
+    Machine machine;
+    EventQueue<Event, QueueCapacity> queue;
+    std::atomic<long> pending{0};
+  };
+
+  void schedule(Session& session)
+  {
+    scheduled.fetch_add(1, std::memory_order_relaxed);
+    pool.submit([this, &session] { drain(session); });
+  }
+
+  void drain(Session& session)
+  {
+    Event event;
+    long processed = 0;
+    while (processed < static_cast<long>(budget) && session.queue.pop(event))
+    {
+      boost::apply_visitor([&session](const auto& e) { session.machine.process_event(e); }, event);
+      ++processed;
+    }
+    // bounded batches keep one chatty machine from starving the others
+    auto remaining = session.pending.fetch_sub(processed, std::memory_order_acq_rel) - processed;
+    if (remaining > 0)
+      pool.submit([this, &session] { drain(session); });
+    else
+      scheduled.fetch_sub(1, std::memory_order_release);
+  }
+
+  WorkStealingPool& pool;
+  size_t budget;
+  std::vector<std::unique_ptr<Session>> sessions;
+  std::atomic<size_t> scheduled{0}; // machines queued or running
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+
+// one line of a rule set: in state `from`, `trigger` moves to `to`
+template <typename State, typename Trigger> struct Rule
+{
+  State from;
+  Trigger trigger;
+  State to;
+};
+
+// dense [state][trigger] -> state table for enums whose values run from 0
+// to StateCount - 1 and TriggerCount - 1. built from a list of rules at
+// compile time, so a step is a single indexed load. a pair without a rule
+// maps to the sentinel `undefined`, the value one past the last state
+template <typename State, typename Trigger, size_t StateCount, size_t TriggerCount>
+class TransitionTable
+{
+public:
+  static constexpr State undefined = static_cast<State>(StateCount);
+
+  template <size_t N>
+  explicit constexpr TransitionTable(const Rule<State, Trigger> (&rules)[N])
+  {
+    for (size_t s = 0; s < StateCount; ++s)
+      for (size_t t = 0; t < TriggerCount; ++t)
+        next[s][t] = undefined;
+    for (size_t i = 0; i < N; ++i)
+    {
+      auto s = static_cast<size_t>(rules[i].from);
+      auto t = static_cast<size_t>(rules[i].trigger);
+      // both throws turn into compile errors when the table is constexpr
+      if (s >= StateCount || t >= TriggerCount || static_cast<size_t>(rules[i].to) >= StateCount)
+        throw std::out_of_range("rule outside the table");
+      if (next[s][t] != undefined)
+        throw std::logic_error("two rules for the same state and trigger");
+      next[s][t] = rules[i].to;
+    }
+  }
+
+  constexpr State operator()(State from, Trigger trigger) const
+  {
+    return next[static_cast<size_t>(from)][static_cast<size_t>(trigger)];
+  }
+
+  constexpr bool defined(State from, Trigger trigger) const
+  {
+    return (*this)(from, trigger) != undefined;
+  }
+
+private:
+  State next[StateCount][TriggerCount]{};
+};
+
+template <typename State, typename Trigger, size_t StateCount, size_t TriggerCount>
+constexpr State TransitionTable<State, Trigger, StateCount, TriggerCount>::undefined;
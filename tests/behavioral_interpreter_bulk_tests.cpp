@@ -0,0 +1,92 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <gtest/gtest.h>
+
+#include "interpreter/behavioral_interpreter_bulk.h"
+
+namespace
+{
+  std::string temp_path(const std::string& name)
+  {
+    return ::testing::TempDir() + "dp_tests_bulk_" + name;
+  }
+
+  void write_file(const std::string& path, const std::string& text)
+  {
+    std::ofstream{ path, std::ios::binary } << text;
+  }
+
+  std::string read_file(const std::string& path)
+  {
+    std::ostringstream text;
+    text << std::ifstream{ path, std::ios::binary }.rdbuf();
+    return text.str();
+  }
+
+  struct BulkTests : ::testing::Test
+  {
+    std::string input = temp_path("input.txt"), output = temp_path("output.txt");
+    int variables[variable_count] = {};
+
+    void TearDown() override
+    {
+      std::remove(input.c_str());
+      std::remove(output.c_str());
+    }
+  };
+}
+
+TEST_F(BulkTests, ResultsComeOutInInputOrderAcrossManySmallChunks)
+{
+  variables[0] = 1; // a
+  std::string text, expected;
+  const int lines = 20000;
+  for (int i = 0; i < lines; ++i)
+  {
+    if (i % 7 == 3)
+    {
+      text += "(" + std::to_string(i) + "\n";
+      expected += "error\n";
+    }
+    else
+    {
+      text += std::to_string(i) + "*3+a\n";
+      expected += std::to_string(i * 3 + 1) + "\n";
+    }
+  }
+  write_file(input, text);
+
+  WorkStealingPool pool{ 4 };
+  auto report = evaluate_file(input, output, variables, pool, 64);
+  EXPECT_EQ(expected, read_file(output));
+  EXPECT_EQ(static_cast<size_t>(lines), report.expressions);
+  EXPECT_EQ(static_cast<size_t>((lines + 3) / 7), report.errors);
+  EXPECT_EQ(text.size(), report.bytes);
+}
+
+TEST_F(BulkTests, LastLineWithoutNewlineIsEvaluated)
+{
+  write_file(input, "1+1\n2*3");
+  WorkStealingPool pool{ 2 };
+  auto report = evaluate_file(input, output, variables, pool);
+  EXPECT_EQ("2\n6\n", read_file(output));
+  EXPECT_EQ(2u, report.expressions);
+}
+
+TEST_F(BulkTests, EmptyInputWritesEmptyOutput)
+{
+  write_file(input, "");
+  WorkStealingPool pool{ 2 };
+  auto report = evaluate_file(input, output, variables, pool);
+  EXPECT_EQ("", read_file(output));
+  EXPECT_EQ(0u, report.expressions);
+}
+
+TEST_F(BulkTests, MissingInputThrows)
+{
+  WorkStealingPool pool{ 1 };
+  EXPECT_THROW(evaluate_file(temp_path("does_not_exist.txt"), output, variables, pool), std::runtime_error);
+}
@@ -0,0 +1,115 @@
+#include <climits>
+#include <random>
+#include <string>
+#include <gtest/gtest.h>
+
+#include "interpreter/behavioral_interpreter_bytecode.h"
+
+namespace
+{
+  // random expression text with every operator, literals, variables,
+  // negation and parentheses; `depth` bounds the nesting
+  std::string random_expression(std::mt19937& rng, int depth)
+  {
+    auto pick = rng() % 8;
+    if (depth == 0 || pick < 2)
+    {
+      if (rng() & 1)
+        return std::to_string(rng() % 1000);
+      return std::string(1, static_cast<char>('a' + rng() % variable_count));
+    }
+    if (pick == 2)
+      return "-" + random_expression(rng, depth - 1);
+    const char ops[] = { '+', '-', '*' };
+    return "(" + random_expression(rng, depth - 1) + ops[rng() % 3] + random_expression(rng, depth - 1) + ")";
+  }
+
+  int run(const std::string& input, const int* variables)
+  {
+    ExpressionArena arena;
+    PrattParser parser;
+    ExpressionVM vm;
+    return vm.run(compile(parser.parse(input, arena)), variables);
+  }
+}
+
+TEST(ExpressionVMTests, MatchesTreeEvaluationOnRandomExpressions)
+{
+  std::mt19937 rng{ 27 };
+  ExpressionArena arena;
+  PrattParser parser;
+  ExpressionVM vm;
+  int variables[variable_count];
+  for (int i = 0; i < 2000; ++i)
+  {
+    auto input = random_expression(rng, 8);
+    arena.reset();
+    auto root = parser.parse(input, arena);
+    auto program = compile(root);
+    for (auto& v : variables)
+      v = static_cast<int>(rng() % 200) - 100;
+    ASSERT_EQ(root->eval(variables), vm.run(program, variables)) << input;
+  }
+}
+
+TEST(ExpressionVMTests, FusedLeafOperandsKeepOperandOrder)
+{
+  int variables[variable_count] = {};
+  variables[0] = 10; // a
+  variables[1] = 3;  // b
+  EXPECT_EQ(7, run("a-3", variables));
+  EXPECT_EQ(7, run("a-b", variables));
+  EXPECT_EQ(-7, run("b-a", variables));
+  EXPECT_EQ(13, run("a+b", variables));
+  EXPECT_EQ(30, run("a*b", variables));
+  EXPECT_EQ(-30, run("-a*b", variables));
+}
+
+TEST(ExpressionVMTests, OverflowWrapsLikeTreeEvaluation)
+{
+  int variables[variable_count] = {};
+  variables[0] = INT_MAX;
+  variables[1] = INT_MIN;
+  for (auto input : { "a+1", "b-1", "a*a", "-b", "a*2+b*2", "(a+a)*(b-a)" })
+  {
+    ExpressionArena arena;
+    PrattParser parser;
+    auto root = parser.parse(input, arena);
+    EXPECT_EQ(root->eval(variables), run(input, variables)) << input;
+  }
+  EXPECT_EQ(INT_MIN, run("a+1", variables));
+  EXPECT_EQ(INT_MAX, run("b-1", variables));
+  EXPECT_EQ(INT_MIN, run("-b", variables));
+}
+
+TEST(ExpressionVMTests, StackDepthIsEnoughForDeepRightNesting)
+{
+  // every right operand is an interior node, so nothing fuses and the
+  // stack grows with the depth
+  const int depth = 5000;
+  std::string input;
+  for (int i = 0; i < depth; ++i)
+    input += "1-(";
+  input += "1";
+  input += std::string(depth, ')');
+  ExpressionArena arena;
+  PrattParser parser;
+  auto program = compile(parser.parse(input, arena));
+  EXPECT_GE(program.max_stack, static_cast<size_t>(depth));
+  int variables[variable_count] = {};
+  ExpressionVM vm;
+  EXPECT_EQ(1, vm.run(program, variables));
+}
+
+TEST(ExpressionVMTests, VMIsReusableAcrossPrograms)
+{
+  ExpressionArena arena;
+  PrattParser parser;
+  ExpressionVM vm;
+  int variables[variable_count] = {};
+  auto small = compile(parser.parse("1+2", arena));
+  auto big = compile(parser.parse("1*(2+(3*(4+(5*(6+7)))))", arena));
+  EXPECT_EQ(3, vm.run(small, variables));
+  EXPECT_EQ(1*(2+(3*(4+(5*(6+7))))), vm.run(big, variables));
+  EXPECT_EQ(3, vm.run(small, variables));
+}
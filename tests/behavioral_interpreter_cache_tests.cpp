@@ -0,0 +1,119 @@
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "interpreter/behavioral_interpreter_cache.h"
+
+namespace
+{
+  int run(const Program& program)
+  {
+    static const int zeros[variable_count] = {};
+    ExpressionVM vm;
+    return vm.run(program, zeros);
+  }
+
+  // the accounted size of one cached "1+<letter>" entry; they all have the
+  // same text length and code, so they are all the same size
+  size_t entry_bytes()
+  {
+    ExpressionCache probe{ 1 << 20, 1 };
+    probe.get("1+a");
+    return probe.stats().bytes;
+  }
+}
+
+TEST(ExpressionCacheTests, NormalizeDropsWhitespaceExceptBetweenWords)
+{
+  EXPECT_EQ("1+2*(a-3)", ExpressionCache::normalize(" 1 + 2 *\t( a - 3 ) "));
+  EXPECT_EQ("1 2", ExpressionCache::normalize("1   2"));
+  EXPECT_EQ("a b", ExpressionCache::normalize("a\nb"));
+  EXPECT_EQ("12", ExpressionCache::normalize("12"));
+}
+
+TEST(ExpressionCacheTests, SpellingsOfTheSameExpressionShareAnEntry)
+{
+  ExpressionCache cache{ 1 << 20 };
+  auto first = cache.get("1+2*3");
+  auto second = cache.get(" 1 + 2 * 3 ");
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(7, run(*first));
+  auto stats = cache.stats();
+  EXPECT_EQ(1u, stats.misses);
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(1u, stats.entries);
+}
+
+TEST(ExpressionCacheTests, WordsSeparatedByWhitespaceStayAnError)
+{
+  ExpressionCache cache{ 1 << 20 };
+  EXPECT_EQ(12, run(*cache.get("12")));
+  EXPECT_THROW(cache.get("1 2"), std::invalid_argument);
+  EXPECT_EQ(1u, cache.stats().entries);
+}
+
+TEST(ExpressionCacheTests, EvictsToStayWithinCapacity)
+{
+  const auto bytes = entry_bytes();
+  ExpressionCache cache{ 3 * bytes, 1 };
+  for (char v = 'a'; v <= 'z'; ++v)
+    cache.get(std::string{ "1+" } + v);
+  auto stats = cache.stats();
+  EXPECT_LE(stats.bytes, 3 * bytes);
+  EXPECT_EQ(3u, stats.entries);
+  EXPECT_EQ(23u, stats.evictions);
+}
+
+TEST(ExpressionCacheTests, ClockGivesReferencedEntriesASecondChance)
+{
+  const auto bytes = entry_bytes();
+  ExpressionCache cache{ 3 * bytes, 1 };
+  cache.get("1+a");
+  cache.get("1+b");
+  cache.get("1+c");
+  cache.get("1+a"); // referenced: survives the next sweep
+  cache.get("1+d"); // evicts b, the first unreferenced entry
+
+  auto before = cache.stats();
+  EXPECT_EQ(1u, before.evictions);
+  cache.get("1+a");
+  cache.get("1+c");
+  cache.get("1+d");
+  EXPECT_EQ(before.hits + 3, cache.stats().hits);
+  cache.get("1+b");
+  EXPECT_EQ(before.misses + 1, cache.stats().misses);
+}
+
+TEST(ExpressionCacheTests, EntriesBiggerThanAShardAreNotCached)
+{
+  ExpressionCache cache{ 1, 1 };
+  EXPECT_EQ(5, run(*cache.get("2+3")));
+  auto stats = cache.stats();
+  EXPECT_EQ(0u, stats.entries);
+  EXPECT_EQ(0u, stats.bytes);
+}
+
+TEST(ExpressionCacheTests, ConcurrentReadersSeeConsistentPrograms)
+{
+  ExpressionCache cache{ 1 << 16, 4 };
+  const int threads = 4, rounds = 2000;
+  std::vector<std::thread> workers;
+  std::vector<int> wrong(threads, 0);
+  for (int t = 0; t < threads; ++t)
+    workers.emplace_back([&, t] {
+      for (int i = 0; i < rounds; ++i)
+      {
+        auto n = (i * 7 + t) % 50;
+        if (run(*cache.get(std::to_string(n) + "*2")) != n * 2)
+          ++wrong[t];
+      }
+    });
+  for (auto& w : workers)
+    w.join();
+  for (auto w : wrong)
+    EXPECT_EQ(0, w);
+  auto stats = cache.stats();
+  EXPECT_EQ(static_cast<size_t>(threads * rounds), stats.hits + stats.misses);
+}
@@ -0,0 +1,110 @@
+#include <climits>
+#include <random>
+#include <string>
+#include <gtest/gtest.h>
+
+#include "interpreter/behavioral_interpreter_optimizer.h"
+#include "interpreter/behavioral_interpreter_bytecode.h"
+
+namespace
+{
+  struct Optimized
+  {
+    ExpressionArena arena;
+    PrattParser parser;
+    ExpressionOptimizer optimizer;
+    const AstNode* original = nullptr;
+    const AstNode* root = nullptr;
+
+    explicit Optimized(const std::string& input)
+    {
+      original = parser.parse(input, arena);
+      root = optimizer.optimize(original, arena);
+    }
+  };
+
+  std::string random_expression(std::mt19937& rng, int depth)
+  {
+    auto pick = rng() % 8;
+    if (depth == 0 || pick < 2)
+    {
+      // few distinct leaves, so identities and shared subtrees come up
+      if (rng() & 1)
+        return std::to_string(rng() % 3);
+      return std::string(1, static_cast<char>('x' + rng() % 3));
+    }
+    if (pick == 2)
+      return "-" + random_expression(rng, depth - 1);
+    const char ops[] = { '+', '-', '*' };
+    return "(" + random_expression(rng, depth - 1) + ops[rng() % 3] + random_expression(rng, depth - 1) + ")";
+  }
+}
+
+TEST(ExpressionOptimizerTests, FoldsConstantSubtrees)
+{
+  Optimized e{ "2*3-6+(4-1)*2" };
+  ASSERT_EQ(AstNode::integer, e.root->type);
+  EXPECT_EQ(6, e.root->value);
+}
+
+TEST(ExpressionOptimizerTests, FoldingWrapsLikeEvaluation)
+{
+  Optimized e{ "2147483647+1" };
+  ASSERT_EQ(AstNode::integer, e.root->type);
+  EXPECT_EQ(INT_MIN, e.root->value);
+}
+
+TEST(ExpressionOptimizerTests, SimplifiesIdentities)
+{
+  for (auto input : { "x-0", "0+x", "x*1", "1*x", "--x", "x+(2*3-6)" })
+  {
+    Optimized e{ input };
+    EXPECT_EQ(AstNode::variable, e.root->type) << input;
+    EXPECT_EQ('x' - 'a', e.root->value) << input;
+  }
+  for (auto input : { "x-x", "0*x", "(x+y)*0", "(x+y)-(y+x)" })
+  {
+    Optimized e{ input };
+    ASSERT_EQ(AstNode::integer, e.root->type) << input;
+    EXPECT_EQ(0, e.root->value) << input;
+  }
+  Optimized negated{ "x*-1" };
+  EXPECT_EQ(AstNode::negation, negated.root->type);
+}
+
+TEST(ExpressionOptimizerTests, HashConsesIdenticalSubtrees)
+{
+  Optimized e{ "(x+y)*(y+x)" };
+  ASSERT_EQ(AstNode::multiplication, e.root->type);
+  EXPECT_EQ(e.root->lhs, e.root->rhs); // addition is put in canonical order
+  EXPECT_EQ(4u, e.optimizer.unique_nodes()); // x, y, x+y, (x+y)*(x+y)
+}
+
+TEST(ExpressionOptimizerTests, RepeatedTextCostsOnlyTheUniqueWork)
+{
+  std::string input{ "x*y" };
+  for (int i = 0; i < 12; ++i)
+    input = "(" + input + ")+(" + input + ")";
+  Optimized e{ input };
+  // the text has 2^12 copies of x*y, the DAG one per level
+  EXPECT_EQ(3u + 12, e.optimizer.unique_nodes());
+  auto program = compile(e.root, true);
+  EXPECT_LT(program.code.size(), 64u);
+}
+
+TEST(ExpressionOptimizerTests, PreservesValueOnRandomExpressions)
+{
+  std::mt19937 rng{ 30 };
+  ExpressionVM vm;
+  int variables[variable_count] = {};
+  for (int i = 0; i < 1000; ++i)
+  {
+    auto input = random_expression(rng, 7);
+    Optimized e{ input };
+    for (int v = 0; v < 3; ++v)
+      variables['x' - 'a' + v] = static_cast<int>(rng() % 21) - 10;
+    auto expected = e.original->eval(variables);
+    ASSERT_EQ(expected, e.root->eval(variables)) << input;
+    ASSERT_EQ(expected, vm.run(compile(e.root, true), variables)) << input;
+  }
+}
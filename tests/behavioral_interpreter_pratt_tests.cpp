@@ -0,0 +1,109 @@
+#include <climits>
+#include <stdexcept>
+#include <string>
+#include <gtest/gtest.h>
+
+#include "interpreter/behavioral_interpreter_pratt.h"
+
+namespace
+{
+  int evaluate(const std::string& input, const int* variables = nullptr)
+  {
+    static const int zeros[variable_count] = {};
+    ExpressionArena arena;
+    PrattParser parser;
+    return parser.parse(input, arena)->eval(variables ? variables : zeros);
+  }
+
+  // the message of the invalid_argument parse() throws, "" if it doesn't
+  std::string parse_error(const std::string& input)
+  {
+    ExpressionArena arena;
+    PrattParser parser;
+    try
+    {
+      parser.parse(input, arena);
+    }
+    catch (const std::invalid_argument& e)
+    {
+      return e.what();
+    }
+    return "";
+  }
+}
+
+TEST(PrattParserTests, MultiplicationBindsTighterThanAdditionAndSubtraction)
+{
+  EXPECT_EQ(7, evaluate("1+2*3"));
+  EXPECT_EQ(5, evaluate("2*3-1"));
+  EXPECT_EQ(-5, evaluate("1-2*3"));
+  EXPECT_EQ(9, evaluate("(1+2)*3"));
+}
+
+TEST(PrattParserTests, BinaryOperatorsAreLeftAssociative)
+{
+  EXPECT_EQ(-5, evaluate("2-3-4"));
+  EXPECT_EQ(3, evaluate("2-3+4"));
+  EXPECT_EQ(24, evaluate("2*3*4"));
+}
+
+TEST(PrattParserTests, NegationBindsTightest)
+{
+  EXPECT_EQ(-6, evaluate("-2*3"));
+  EXPECT_EQ(-6, evaluate("2*-3"));
+  EXPECT_EQ(5, evaluate("--5"));
+  EXPECT_EQ(1, evaluate("-(2-3)"));
+  EXPECT_EQ(-1, evaluate("1--2*-1"));
+}
+
+TEST(PrattParserTests, VariablesReadTheirSlots)
+{
+  int variables[variable_count] = {};
+  variables[0] = 4;  // a
+  variables[25] = 7; // z
+  EXPECT_EQ(32, evaluate("a*(z+1)", variables));
+  EXPECT_EQ(0, evaluate("b", variables));
+}
+
+TEST(PrattParserTests, WhitespaceIsIgnored)
+{
+  EXPECT_EQ(7, evaluate(" 1 +\t2 * 3 "));
+}
+
+TEST(PrattParserTests, DeepNestingDoesNotRecurse)
+{
+  const int depth = 100000;
+  std::string input(depth, '(');
+  input += "0";
+  for (int i = 0; i < depth; ++i)
+    input += "+1)";
+  EXPECT_EQ(depth, evaluate(input));
+}
+
+TEST(PrattParserTests, LiteralsUpToIntMaxParse)
+{
+  EXPECT_EQ(INT_MAX, evaluate("2147483647"));
+  EXPECT_EQ("number out of range at offset 9", parse_error("2147483648"));
+  EXPECT_EQ("number out of range at offset 11", parse_error("1+99999999999"));
+}
+
+TEST(PrattParserTests, MalformedInputReportsWhereItFailed)
+{
+  EXPECT_EQ("unexpected end of input at offset 0", parse_error(""));
+  EXPECT_EQ("unexpected end of input at offset 2", parse_error("1+"));
+  EXPECT_EQ("expected a number, variable or '(' at offset 2", parse_error("1+*2"));
+  EXPECT_EQ("expected a number, variable or '(' at offset 0", parse_error("A"));
+  EXPECT_EQ("expected an operator or ')' at offset 2", parse_error("1 2"));
+  EXPECT_EQ("expected an operator or ')' at offset 1", parse_error("a("));
+  EXPECT_EQ("unbalanced ')' at offset 3", parse_error("1+2)"));
+  EXPECT_EQ("unbalanced '(' at offset 4", parse_error("(1+2"));
+}
+
+TEST(PrattParserTests, ParserIsReusableAfterAnError)
+{
+  ExpressionArena arena;
+  PrattParser parser;
+  EXPECT_THROW(parser.parse("(1+", arena), std::invalid_argument);
+  static const int zeros[variable_count] = {};
+  EXPECT_EQ(3, parser.parse("1+2", arena)->eval(zeros));
+}
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "iterator/behavioral_iterator_array_tree.h"
+
+namespace
+{
+  // the tree's shape without the tree: node i has children 2i and 2i+1 up
+  // to n, and the values are assigned in order
+  struct Shape
+  {
+    size_t n;
+    std::vector<int> in_order_rank; // by index
+    int next_rank = 0;
+
+    explicit Shape(size_t n) : n{n}, in_order_rank(n + 1)
+    {
+      rank(1);
+    }
+
+    void rank(size_t i)
+    {
+      if (i > n) return;
+      rank(2 * i);
+      in_order_rank[i] = next_rank++;
+      rank(2 * i + 1);
+    }
+
+    void pre(size_t i, std::vector<int>& out) const
+    {
+      if (i > n) return;
+      out.push_back(in_order_rank[i]);
+      pre(2 * i, out);
+      pre(2 * i + 1, out);
+    }
+
+    void post(size_t i, std::vector<int>& out) const
+    {
+      if (i > n) return;
+      post(2 * i, out);
+      post(2 * i + 1, out);
+      out.push_back(in_order_rank[i]);
+    }
+  };
+
+  std::vector<int> iota_vector(size_t n)
+  {
+    std::vector<int> v(n);
+    std::iota(v.begin(), v.end(), 0);
+    return v;
+  }
+}
+
+TEST(ArrayBinaryTreeTests, TraversalsMatchRecursiveOnesForEverySizeUpTo130)
+{
+  for (size_t n = 0; n <= 130; ++n)
+  {
+    auto sorted = iota_vector(n);
+    ArrayBinaryTree<int> tree{ sorted.begin(), sorted.end() };
+    Shape shape{ n };
+    std::vector<int> pre, post;
+    shape.pre(1, pre);
+    shape.post(1, post);
+
+    EXPECT_EQ(sorted, std::vector<int>(tree.begin(), tree.end())) << n;
+    EXPECT_EQ(pre, std::vector<int>(tree.pre_order.begin(), tree.pre_order.end())) << n;
+    auto post_order = tree.post_order();
+    EXPECT_EQ(post, std::vector<int>(post_order.begin(), post_order.end())) << n;
+  }
+}
+
+TEST(ArrayBinaryTreeTests, LowerBoundMatchesStdLowerBound)
+{
+  for (size_t n : { 0, 1, 2, 7, 8, 100, 1000, 4097 })
+  {
+    std::vector<int> sorted(n);
+    for (size_t i = 0; i < n; ++i)
+      sorted[i] = static_cast<int>(2 * i); // odd keys miss
+    ArrayBinaryTree<int> tree{ sorted.begin(), sorted.end() };
+    for (int k = -1; k <= static_cast<int>(2 * n) + 1; ++k)
+    {
+      auto expected = std::lower_bound(sorted.begin(), sorted.end(), k);
+      auto found = tree.lower_bound(k);
+      if (expected == sorted.end())
+      {
+        EXPECT_TRUE(found == tree.end()) << n << " " << k;
+      }
+      else
+      {
+        ASSERT_TRUE(found != tree.end()) << n << " " << k;
+        EXPECT_EQ(*expected, *found);
+      }
+      EXPECT_EQ(std::binary_search(sorted.begin(), sorted.end(), k), tree.contains(k));
+    }
+  }
+}
+
+TEST(ArrayBinaryTreeTests, AtWalksToTheRankInOrder)
+{
+  auto sorted = iota_vector(1000);
+  ArrayBinaryTree<int> tree{ sorted.begin(), sorted.end() };
+  for (size_t rank = 0; rank < 1000; ++rank)
+    ASSERT_EQ(static_cast<int>(rank), *tree.at(rank));
+  EXPECT_TRUE(tree.at(1000) == tree.end());
+}
+
+TEST(ArrayBinaryTreeTests, SplitCoversTheValuesInOrder)
+{
+  auto sorted = iota_vector(1000);
+  ArrayBinaryTree<int> tree{ sorted.begin(), sorted.end() };
+  for (size_t parts : { 1, 2, 7, 1000, 3000 })
+  {
+    auto ranges = tree.split(parts);
+    EXPECT_EQ(std::min<size_t>(parts, 1000), ranges.size());
+    int next = 0;
+    for (auto& range : ranges)
+    {
+      auto length = std::distance(range.first, range.second);
+      EXPECT_GE(length, static_cast<std::ptrdiff_t>(1000 / ranges.size()));
+      EXPECT_LE(length, static_cast<std::ptrdiff_t>(1000 / ranges.size() + 1));
+      for (auto it = range.first; it != range.second; ++it)
+        EXPECT_EQ(next++, *it);
+    }
+    EXPECT_EQ(1000, next);
+  }
+}
@@ -0,0 +1,161 @@
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "iterator/behavioral_iterator_unrolled_list.h"
+
+namespace
+{
+  // small chunks, so a few dozen strings span many of them
+  using List = UnrolledList<std::string, 128>;
+
+  std::vector<std::string> contents(const List& list)
+  {
+    return std::vector<std::string>(list.begin(), list.end());
+  }
+
+  List::const_iterator at(const List& list, size_t position)
+  {
+    return std::next(list.begin(), static_cast<std::ptrdiff_t>(position));
+  }
+}
+
+TEST(UnrolledListTests, AppendKeepsOrder)
+{
+  List list;
+  std::vector<std::string> expected;
+  for (int i = 0; i < 100; ++i)
+  {
+    list.push_back(std::to_string(i));
+    expected.push_back(std::to_string(i));
+  }
+  EXPECT_EQ(100u, list.size());
+  EXPECT_EQ(expected, contents(list));
+}
+
+TEST(UnrolledListTests, InsertingIntoAFullChunkSplitsIt)
+{
+  List list;
+  for (int i = 0; i < 40; ++i)
+    list.push_back(std::to_string(i));
+  std::vector<std::string> expected = contents(list);
+
+  // the front chunk is full, so this moves its upper half into a new chunk
+  auto it = list.insert(at(list, 1), "x");
+  EXPECT_EQ("x", *it);
+  expected.insert(expected.begin() + 1, "x");
+  EXPECT_EQ(expected, contents(list));
+
+  size_t chunks = 0;
+  list.for_each_block([&](Block<const std::string>) { ++chunks; });
+  List appended;
+  for (auto& s : expected)
+    appended.push_back(s);
+  size_t appended_chunks = 0;
+  appended.for_each_block([&](Block<const std::string>) { ++appended_chunks; });
+  EXPECT_GT(chunks, appended_chunks);
+}
+
+TEST(UnrolledListTests, InsertAtEndAppends)
+{
+  List list;
+  list.insert(list.end(), "a");
+  list.insert(list.end(), "b");
+  EXPECT_EQ((std::vector<std::string>{ "a", "b" }), contents(list));
+}
+
+TEST(UnrolledListTests, EraseReturnsTheNextElement)
+{
+  List list;
+  for (int i = 0; i < 10; ++i)
+    list.push_back(std::to_string(i));
+  auto it = list.erase(at(list, 3));
+  EXPECT_EQ("4", *it);
+  it = list.erase(at(list, 8)); // the last one
+  EXPECT_TRUE(it == list.end());
+  EXPECT_EQ((std::vector<std::string>{ "0", "1", "2", "4", "5", "6", "7", "8" }), contents(list));
+  EXPECT_EQ(8u, list.size());
+}
+
+TEST(UnrolledListTests, ErasingEverythingFromEitherEndLeavesAnEmptyList)
+{
+  List front, back;
+  for (int i = 0; i < 50; ++i)
+  {
+    front.push_back(std::to_string(i));
+    back.push_back(std::to_string(i));
+  }
+  for (int i = 0; i < 50; ++i)
+  {
+    auto it = front.erase(front.begin());
+    if (i + 1 < 50)
+    {
+      EXPECT_EQ(std::to_string(i + 1), *it);
+    }
+    back.erase(at(back, back.size() - 1));
+  }
+  EXPECT_TRUE(front.empty());
+  EXPECT_TRUE(back.empty());
+  EXPECT_TRUE(front.begin() == front.end());
+  EXPECT_TRUE(back.begin() == back.end());
+  front.push_back("again");
+  EXPECT_EQ(std::vector<std::string>{ "again" }, contents(front));
+}
+
+TEST(UnrolledListTests, RandomInsertsAndErasesMatchAVector)
+{
+  std::mt19937 rng{ 41 };
+  List list;
+  std::vector<std::string> expected;
+  for (int step = 0; step < 5000; ++step)
+  {
+    if (expected.empty() || rng() % 3)
+    {
+      auto position = rng() % (expected.size() + 1);
+      auto value = std::to_string(step);
+      auto it = list.insert(at(list, position), value);
+      EXPECT_EQ(value, *it);
+      expected.insert(expected.begin() + position, value);
+    }
+    else
+    {
+      auto position = rng() % expected.size();
+      auto it = list.erase(at(list, position));
+      expected.erase(expected.begin() + position);
+      EXPECT_TRUE(position < expected.size() ? expected[position] == *it : it == list.end());
+    }
+  }
+  EXPECT_EQ(expected.size(), list.size());
+  EXPECT_EQ(expected, contents(list));
+}
+
+TEST(UnrolledListTests, SplitCoversTheListInOrder)
+{
+  UnrolledList<int, 64> list;
+  for (int i = 0; i < 1000; ++i)
+    list.push_back(i);
+  for (size_t parts : { 1, 3, 8, 1000, 5000 })
+  {
+    auto ranges = list.split(parts);
+    ASSERT_FALSE(ranges.empty());
+    EXPECT_LE(ranges.size(), parts);
+    EXPECT_TRUE(ranges.front().first == list.begin());
+    EXPECT_TRUE(ranges.back().second == list.end());
+    int next = 0;
+    for (size_t r = 0; r < ranges.size(); ++r)
+    {
+      if (r > 0)
+      {
+        EXPECT_TRUE(ranges[r - 1].second == ranges[r].first);
+      }
+      EXPECT_TRUE(ranges[r].first != ranges[r].second) << "empty range";
+      for (auto it = ranges[r].first; it != ranges[r].second; ++it)
+        EXPECT_EQ(next++, *it);
+    }
+    EXPECT_EQ(1000, next);
+  }
+  EXPECT_TRUE(list.split(0).empty());
+  EXPECT_TRUE(UnrolledList<int>{}.split(4).empty());
+}
@@ -0,0 +1,94 @@
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "state/behavioral_state_runtime.h"
+
+TEST(EventQueueTests, PopsInPushOrder)
+{
+  EventQueue<int, 8> queue;
+  int value = -1;
+  EXPECT_FALSE(queue.pop(value));
+  for (int i = 0; i < 5; ++i)
+    EXPECT_TRUE(queue.push(i));
+  for (int i = 0; i < 5; ++i)
+  {
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_FALSE(queue.pop(value));
+}
+
+TEST(EventQueueTests, RejectsPushesWhenFull)
+{
+  EventQueue<int, 4> queue;
+  for (int i = 0; i < 4; ++i)
+    EXPECT_TRUE(queue.push(i));
+  EXPECT_FALSE(queue.push(4));
+  int value;
+  ASSERT_TRUE(queue.pop(value));
+  EXPECT_EQ(0, value);
+  EXPECT_TRUE(queue.push(4)); // the freed slot is reused
+  for (int i = 1; i <= 4; ++i)
+  {
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(i, value);
+  }
+}
+
+TEST(EventQueueTests, WrapsAroundManyTimes)
+{
+  EventQueue<int, 4> queue;
+  int value;
+  for (int i = 0; i < 1000; ++i)
+  {
+    ASSERT_TRUE(queue.push(i));
+    ASSERT_TRUE(queue.push(-i));
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(i, value);
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(-i, value);
+  }
+}
+
+TEST(EventQueueTests, ManyProducersOneConsumerLoseNothingAndKeepPerProducerOrder)
+{
+  const int producers = 4, per_producer = 20000;
+  EventQueue<uint64_t, 64> queue;
+  std::atomic<bool> go{ false };
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p)
+    threads.emplace_back([&, p] {
+      while (!go.load())
+        std::this_thread::yield();
+      for (uint64_t i = 0; i < per_producer; ++i)
+        while (!queue.push(static_cast<uint64_t>(p) << 32 | i))
+          std::this_thread::yield(); // full: let the consumer catch up
+    });
+
+  go.store(true);
+  std::vector<uint64_t> next(producers, 0);
+  int received = 0, out_of_order = 0;
+  uint64_t value;
+  while (received < producers * per_producer)
+  {
+    if (!queue.pop(value))
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    auto p = value >> 32, i = value & 0xffffffff;
+    out_of_order += i != next[p];
+    next[p] = i + 1;
+    ++received;
+  }
+  for (auto& t : threads)
+    t.join();
+
+  EXPECT_EQ(0, out_of_order);
+  for (auto n : next)
+    EXPECT_EQ(static_cast<uint64_t>(per_producer), n);
+  EXPECT_FALSE(queue.pop(value));
+}
@@ -0,0 +1,66 @@
+#include <stdexcept>
+#include <gtest/gtest.h>
+
+#include "state/behavioral_state_table.h"
+
+namespace
+{
+  enum class Light { off, on, broken };
+  enum class Switch { flip, smash, repair };
+
+  using LightTable = TransitionTable<Light, Switch, 3, 3>;
+
+  constexpr Rule<Light, Switch> light_rules[] = {
+    { Light::off, Switch::flip,   Light::on },
+    { Light::on,  Switch::flip,   Light::off },
+    { Light::off, Switch::smash,  Light::broken },
+    { Light::on,  Switch::smash,  Light::broken },
+    { Light::broken, Switch::repair, Light::off }
+  };
+
+  constexpr LightTable light_table{ light_rules };
+
+  // built at compile time, so lookups work in constant expressions
+  static_assert(light_table(Light::off, Switch::flip) == Light::on, "");
+  static_assert(light_table(Light::broken, Switch::flip) == LightTable::undefined, "");
+  static_assert(!light_table.defined(Light::on, Switch::repair), "");
+}
+
+TEST(TransitionTableTests, EveryRuleIsInTheTable)
+{
+  for (auto& rule : light_rules)
+  {
+    EXPECT_TRUE(light_table.defined(rule.from, rule.trigger));
+    EXPECT_EQ(rule.to, light_table(rule.from, rule.trigger));
+  }
+}
+
+TEST(TransitionTableTests, PairsWithoutARuleAreUndefined)
+{
+  int defined = 0;
+  for (auto s : { Light::off, Light::on, Light::broken })
+    for (auto t : { Switch::flip, Switch::smash, Switch::repair })
+      defined += light_table.defined(s, t);
+  EXPECT_EQ(5, defined);
+  EXPECT_EQ(static_cast<Light>(3), LightTable::undefined);
+  EXPECT_EQ(LightTable::undefined, light_table(Light::off, Switch::repair));
+}
+
+TEST(TransitionTableTests, ConflictingRulesThrow)
+{
+  const Rule<Light, Switch> conflicting[] = {
+    { Light::off, Switch::flip, Light::on },
+    { Light::off, Switch::flip, Light::broken }
+  };
+  EXPECT_THROW(LightTable{ conflicting }, std::logic_error);
+}
+
+TEST(TransitionTableTests, RulesOutsideTheTableThrow)
+{
+  const Rule<Light, Switch> bad_state[] = { { static_cast<Light>(3), Switch::flip, Light::on } };
+  const Rule<Light, Switch> bad_trigger[] = { { Light::on, static_cast<Switch>(5), Light::on } };
+  const Rule<Light, Switch> bad_target[] = { { Light::on, Switch::flip, static_cast<Light>(3) } };
+  EXPECT_THROW(LightTable{ bad_state }, std::out_of_range);
+  EXPECT_THROW(LightTable{ bad_trigger }, std::out_of_range);
+  EXPECT_THROW(LightTable{ bad_target }, std::out_of_range);
+}
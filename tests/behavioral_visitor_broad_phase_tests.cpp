@@ -0,0 +1,124 @@
+#include <cmath>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "visitor/behavioral_visitor_broad_phase.h"
+
+namespace
+{
+  struct Body
+  {
+    float x, y, radius;
+  };
+
+  using PairSet = std::set<std::pair<const Body*, const Body*>>;
+
+  // unordered pairs, so the order the grid reports them in doesn't matter
+  PairSet normalized(const std::vector<std::pair<Body*, Body*>>& pairs)
+  {
+    PairSet result;
+    for (auto& p : pairs)
+      result.insert(std::minmax<const Body*>(p.first, p.second));
+    return result;
+  }
+
+  PairSet brute_force(const std::vector<Body*>& bodies)
+  {
+    PairSet result;
+    for (size_t i = 0; i < bodies.size(); ++i)
+      for (size_t j = i + 1; j < bodies.size(); ++j)
+      {
+        auto dx = bodies[i]->x - bodies[j]->x, dy = bodies[i]->y - bodies[j]->y;
+        auto r = bodies[i]->radius + bodies[j]->radius;
+        if (dx * dx + dy * dy < r * r)
+          result.insert(std::minmax<const Body*>(bodies[i], bodies[j]));
+      }
+    return result;
+  }
+
+  std::vector<Body> scatter(size_t count, float world, float max_radius, std::mt19937& rng)
+  {
+    std::uniform_real_distribution<float> position(0, world), radius(0.1f, max_radius);
+    std::vector<Body> bodies(count);
+    for (auto& b : bodies)
+      b = { position(rng), position(rng), radius(rng) };
+    return bodies;
+  }
+
+  std::vector<Body*> pointers(std::vector<Body>& bodies)
+  {
+    std::vector<Body*> result;
+    for (auto& b : bodies)
+      result.push_back(&b);
+    return result;
+  }
+}
+
+TEST(BroadPhaseTests, FindsExactlyTheBruteForcePairs)
+{
+  WorkStealingPool pool{ 4 };
+  BroadPhase<Body> broad_phase;
+  std::mt19937 rng{ 36 };
+  // dense and sparse scenes, and fewer objects than tasks
+  for (auto scene : { std::make_pair(3, 2.0f), std::make_pair(100, 20.0f), std::make_pair(3000, 100.0f), std::make_pair(3000, 1000.0f) })
+  {
+    auto bodies = scatter(scene.first, scene.second, 1.0f, rng);
+    auto raw = pointers(bodies);
+    auto& pairs = broad_phase.find_pairs(raw.data(), raw.size(), pool);
+    auto found = normalized(pairs);
+    EXPECT_EQ(pairs.size(), found.size()) << "a pair was reported twice";
+    EXPECT_EQ(brute_force(raw), found) << scene.first << " objects on " << scene.second;
+  }
+}
+
+TEST(BroadPhaseTests, MixedRadiiUseCellsForTheLargest)
+{
+  WorkStealingPool pool{ 2 };
+  BroadPhase<Body> broad_phase;
+  std::mt19937 rng{ 37 };
+  auto bodies = scatter(2000, 200, 0.5f, rng);
+  bodies[0].radius = 25;
+  auto raw = pointers(bodies);
+  auto found = normalized(broad_phase.find_pairs(raw.data(), raw.size(), pool));
+  EXPECT_EQ(brute_force(raw), found);
+  EXPECT_GE(broad_phase.current_cell_size(), 50.0f);
+}
+
+TEST(BroadPhaseTests, NegativeCoordinatesAndTouchingCellBorders)
+{
+  WorkStealingPool pool{ 2 };
+  BroadPhase<Body> broad_phase;
+  // radius 0.5 gives cells of 1; the pairs straddle cell borders
+  std::vector<Body> bodies{ { -10, -10, 0.5f }, { -9.2f, -10, 0.5f }, { -9.2f, -9.2f, 0.5f }, { 5, 5, 0.5f }, { 5.6f, 5.6f, 0.5f } };
+  auto raw = pointers(bodies);
+  auto found = normalized(broad_phase.find_pairs(raw.data(), raw.size(), pool));
+  EXPECT_EQ(brute_force(raw), found);
+  EXPECT_EQ(3u, found.size());
+}
+
+TEST(BroadPhaseTests, HugeExtentsAndNaNPositionsStayCorrect)
+{
+  WorkStealingPool pool{ 2 };
+  BroadPhase<Body> broad_phase;
+  std::mt19937 rng{ 38 };
+  auto bodies = scatter(1000, 50, 1.0f, rng);
+  bodies[0].x = -1e30f;
+  bodies[1].y = 1e30f;
+  bodies[2].x = NAN;
+  bodies[3].radius = NAN;
+  auto raw = pointers(bodies);
+  auto found = normalized(broad_phase.find_pairs(raw.data(), raw.size(), pool));
+  EXPECT_EQ(brute_force(raw), found);
+  EXPECT_FALSE(found.empty());
+}
+
+TEST(BroadPhaseTests, EmptySceneHasNoPairs)
+{
+  WorkStealingPool pool{ 1 };
+  BroadPhase<Body> broad_phase;
+  Body* none = nullptr;
+  EXPECT_TRUE(broad_phase.find_pairs(&none, 0, pool).empty());
+}
@@ -1,8 +1,11 @@
 ﻿#include <iostream>
 #include <string>
 #include <sstream>
+#include <chrono>
 using namespace std;
 
+#include "behavioral_visitor_dispatch_table.h"
+
 // cyclic visitor: based on function overloading
 //                 works only on a stable hierarchy
 // acyclic visitor: based on RTTI
@@ -111,3 +114,153 @@ int main_visitor_acyclic()
 	//getchar();
 	return 0;
 }
+
+// the same expressions and printer on top of the id-indexed dispatch table:
+// no RTTI, no cross-casts, and still no visitor interface listing all nodes
+
+struct TableExpression : TableVisitable
+{
+  using TableVisitable::TableVisitable;
+  virtual ~TableExpression() = default;
+};
+
+struct TableDoubleExpression : TableExpression
+{
+  double value;
+
+  TableDoubleExpression(double value)
+    : TableExpression{node_type_id<TableDoubleExpression>()}, value(value) {}
+};
+
+struct TableAdditionExpression : TableExpression
+{
+  TableExpression *left, *right;
+
+  TableAdditionExpression(TableExpression *left, TableExpression *right)
+    : TableExpression{node_type_id<TableAdditionExpression>()}, left(left), right(right) {}
+
+  ~TableAdditionExpression()
+  {
+    delete left;
+    delete right;
+  }
+};
+
+struct TableExpressionPrinter : VisitsNodes<TableExpressionPrinter,
+                                            TableDoubleExpression,
+                                            TableAdditionExpression>
+{
+  void visit(TableDoubleExpression &obj)
+  {
+    oss << obj.value;
+  }
+
+  void visit(TableAdditionExpression &obj)
+  {
+    oss << "(";
+    dispatch(*this, *obj.left);
+    oss << "+";
+    dispatch(*this, *obj.right);
+    oss << ")";
+  }
+
+  string str() const { return oss.str(); }
+private:
+  ostringstream oss;
+};
+
+namespace
+{
+  // evaluators for the benchmark, one per dispatch mechanism
+  struct CastingEvaluator : VisitorBase,
+                            Visitor<DoubleExpression>,
+                            Visitor<AdditionExpression>
+  {
+    double result = 0;
+
+    void visit(DoubleExpression &obj) override { result = obj.value; }
+
+    void visit(AdditionExpression &obj) override
+    {
+      obj.left->accept(*this);
+      auto left = result;
+      obj.right->accept(*this);
+      result += left;
+    }
+  };
+
+  struct TableEvaluator : VisitsNodes<TableEvaluator,
+                                      TableDoubleExpression,
+                                      TableAdditionExpression>
+  {
+    double result = 0;
+
+    void visit(TableDoubleExpression &obj) { result = obj.value; }
+
+    void visit(TableAdditionExpression &obj)
+    {
+      dispatch(*this, *obj.left);
+      auto left = result;
+      dispatch(*this, *obj.right);
+      result += left;
+    }
+  };
+
+  // balanced tree with `leaves` leaves, i.e. 2 * leaves - 1 nodes
+  template <typename Leaf, typename Sum, typename Node>
+  Node* balanced_tree(size_t leaves)
+  {
+    if (leaves == 1)
+      return new Leaf{1};
+    return new Sum{balanced_tree<Leaf, Sum, Node>(leaves / 2),
+                   balanced_tree<Leaf, Sum, Node>(leaves - leaves / 2)};
+  }
+
+  template <typename F> double seconds(F&& f)
+  {
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  }
+}
+
+int main_visitor_acyclic_table()
+{
+  auto e = new TableAdditionExpression{
+    new TableDoubleExpression{1},
+    new TableAdditionExpression{
+      new TableDoubleExpression{2},
+      new TableDoubleExpression{3}
+    }
+  };
+
+  TableExpressionPrinter ep;
+  dispatch(ep, *e);
+  cout << ep.str() << "\n";
+  delete e;
+
+  const size_t leaves = 5000000; // ~10M nodes
+  const int passes = 5;
+
+  auto casting_tree = balanced_tree<DoubleExpression, AdditionExpression, Expression>(leaves);
+  CastingEvaluator casting;
+  auto casting_time = seconds([&] {
+    for (int i = 0; i < passes; ++i)
+      casting_tree->accept(casting);
+  });
+  delete casting_tree;
+
+  auto table_tree = balanced_tree<TableDoubleExpression, TableAdditionExpression, TableExpression>(leaves);
+  TableEvaluator table;
+  auto table_time = seconds([&] {
+    for (int i = 0; i < passes; ++i)
+      dispatch(table, *table_tree);
+  });
+  delete table_tree;
+
+  auto nodes = static_cast<double>(2 * leaves - 1) * passes;
+  cout << "dynamic_cast: " << casting_time / nodes * 1e9 << " ns/node, sum " << casting.result << "\n"
+       << "id table:     " << table_time / nodes * 1e9 << " ns/node, sum " << table.result << "\n";
+
+  return 0;
+}
@@ -0,0 +1,239 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "../common/work_stealing_pool.h"
+
+// broad phase: buckets the objects in a uniform grid, hashed into a table
+// sized to the object count, and reports only pairs whose bounding circles
+// overlap. the hash is the row-major cell number modulo the table size, so
+// a scene that fits the table gets a dense grid with neighbouring cells
+// close in memory, and a bigger one wraps around instead of failing.
+// the grid is rebuilt from scratch every tick, in parallel:
+//   1. gather positions into flat arrays, find the bounds and largest radius
+//   2. count objects per bucket with atomic increments, keeping each
+//      object's rank within its bucket
+//   3. prefix-sum the counts into bucket offsets
+//   4. scatter the objects into bucket order at offset + rank
+//   5. test each object against its own cell and four of the eight
+//      neighbouring cells, so every pair is looked at exactly once
+// cells are at least twice the largest radius, so overlapping objects are
+// always in the same or adjacent cells
+//
+// Object is any type with float `x`, `y` and `radius` members
+template <typename Object> class BroadPhase
+{
+public:
+  using Pair = std::pair<Object*, Object*>;
+
+  explicit BroadPhase(float min_cell_size = 1) : min_cell_size{ min_cell_size } {}
+
+  const std::vector<Pair>& find_pairs(Object* const* objects, size_t count, WorkStealingPool& pool)
+  {
+    resize(count);
+    // no more tasks than objects, so no task gets an empty range
+    const size_t tasks = std::max<size_t>(1, std::min<size_t>(count, pool.size() * 4));
+
+    std::vector<Bounds> task_bounds(tasks);
+    parallel_for(pool, count, tasks, [&](size_t first, size_t last, size_t task) {
+      Bounds bounds;
+      for (auto i = first; i < last; ++i)
+      {
+        x[i] = objects[i]->x;
+        y[i] = objects[i]->y;
+        radius[i] = objects[i]->radius;
+        bounds.add(x[i], y[i], radius[i]);
+      }
+      task_bounds[task] = bounds;
+    });
+    Bounds bounds;
+    for (auto& b : task_bounds)
+      bounds.add(b);
+    // a scene wider than max_cells cells gets bigger cells instead
+    auto extent = std::max(bounds.max_x - bounds.min_x, bounds.max_y - bounds.min_y);
+    cell_size = std::max({ min_cell_size, 2 * bounds.max_radius, extent / max_cells });
+    origin_x = bounds.min_x;
+    origin_y = bounds.min_y;
+    columns = count ? static_cast<uint32_t>(cell_of(bounds.max_x - bounds.min_x)) + 1 : 1;
+
+    for (size_t b = 0; b <= bucket_count; ++b)
+      counts[b].store(0, std::memory_order_relaxed);
+    parallel_for(pool, count, tasks, [&](size_t first, size_t last, size_t) {
+      for (auto i = first; i < last; ++i)
+      {
+        cell_x[i] = cell_of(x[i] - origin_x);
+        cell_y[i] = cell_of(y[i] - origin_y);
+        bucket[i] = bucket_of(cell_x[i], cell_y[i]);
+        rank[i] = counts[bucket[i]].fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+
+    uint32_t offset = 0;
+    for (size_t b = 0; b < bucket_count; ++b)
+    {
+      bucket_start[b] = offset;
+      offset += counts[b].load(std::memory_order_relaxed);
+    }
+    bucket_start[bucket_count] = offset;
+
+    parallel_for(pool, count, tasks, [&](size_t first, size_t last, size_t) {
+      for (auto i = first; i < last; ++i)
+      {
+        sorted[bucket_start[bucket[i]] + rank[i]] = { x[i], y[i], radius[i], cell_x[i], cell_y[i], objects[i] };
+      }
+    });
+
+    task_pairs.resize(tasks);
+    parallel_for(pool, bucket_count, tasks, [&](size_t first, size_t last, size_t task) {
+      auto& out = task_pairs[task];
+      out.clear();
+      for (auto b = first; b < last; ++b)
+        collect(b, out);
+    });
+
+    pairs.clear();
+    for (auto& p : task_pairs)
+      pairs.insert(pairs.end(), p.begin(), p.end());
+    return pairs;
+  }
+
+  float current_cell_size() const { return cell_size; }
+
+private:
+  struct Entry
+  {
+    float x, y, radius;
+    int32_t cell_x, cell_y;
+    Object* object;
+  };
+
+  struct Bounds
+  {
+    float min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+    float max_radius = 0;
+
+    void add(float x, float y, float radius)
+    {
+      min_x = std::min(min_x, x);
+      min_y = std::min(min_y, y);
+      max_x = std::max(max_x, x);
+      max_y = std::max(max_y, y);
+      max_radius = std::max(max_radius, radius);
+    }
+
+    // component-wise, so an empty Bounds (from an empty range) changes nothing
+    void add(const Bounds& b)
+    {
+      min_x = std::min(min_x, b.min_x);
+      min_y = std::min(min_y, b.min_y);
+      max_x = std::max(max_x, b.max_x);
+      max_y = std::max(max_y, b.max_y);
+      max_radius = std::max(max_radius, b.max_radius);
+    }
+  };
+
+  // splits [0, count) into `tasks` ranges and runs them on the pool
+  template <typename F> static void parallel_for(WorkStealingPool& pool, size_t count, size_t tasks, F f)
+  {
+    TaskGroup group{ pool };
+    for (size_t t = 0; t < tasks; ++t)
+      group.run([=, &f] { f(count * t / tasks, count * (t + 1) / tasks, t); });
+    group.wait();
+  }
+
+  void resize(size_t count)
+  {
+    x.resize(count);
+    y.resize(count);
+    radius.resize(count);
+    cell_x.resize(count);
+    cell_y.resize(count);
+    bucket.resize(count);
+    rank.resize(count);
+    sorted.resize(count);
+
+    size_t wanted = 1;
+    while (wanted < count) wanted *= 2;
+    if (wanted != bucket_count)
+    {
+      bucket_count = wanted;
+      counts.reset(new std::atomic<uint32_t>[bucket_count + 1]);
+      bucket_start.assign(bucket_count + 1, 0);
+    }
+  }
+
+  // cell coordinates stay within [0, max_cells], so they and their
+  // neighbours fit an int32 whatever the positions are; NaN (and the
+  // inf / inf of an infinite position) lands in cell 0, where overlap()
+  // never matches it
+  int32_t cell_of(float coordinate) const
+  {
+    auto cell = std::floor(coordinate / cell_size);
+    if (!(cell >= 0))
+      return 0;
+    return static_cast<int32_t>(cell < max_cells ? cell : max_cells);
+  }
+
+  uint32_t bucket_of(int32_t cx, int32_t cy) const
+  {
+    return (static_cast<uint32_t>(cy) * columns + static_cast<uint32_t>(cx)) % bucket_count;
+  }
+
+  static bool overlap(const Entry& a, const Entry& b)
+  {
+    auto dx = a.x - b.x, dy = a.y - b.y, r = a.radius + b.radius;
+    return dx * dx + dy * dy < r * r;
+  }
+
+  // several cells can share a bucket, so entries are matched on their cell
+  // coordinates, not just on the bucket
+  void collect(size_t b, std::vector<Pair>& out) const
+  {
+    static const int32_t neighbours[4][2] = { { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } };
+
+    for (auto i = bucket_start[b]; i < bucket_start[b + 1]; ++i)
+    {
+      auto& a = sorted[i];
+      for (auto j = i + 1; j < bucket_start[b + 1]; ++j)
+      {
+        auto& c = sorted[j];
+        if (c.cell_x == a.cell_x && c.cell_y == a.cell_y && overlap(a, c))
+          out.push_back({ a.object, c.object });
+      }
+      for (auto& n : neighbours)
+      {
+        auto nx = a.cell_x + n[0], ny = a.cell_y + n[1];
+        auto nb = bucket_of(nx, ny);
+        for (auto j = bucket_start[nb]; j < bucket_start[nb + 1]; ++j)
+        {
+          auto& c = sorted[j];
+          if (c.cell_x == nx && c.cell_y == ny && overlap(a, c))
+            out.push_back({ a.object, c.object });
+        }
+      }
+    }
+  }
+
+  static constexpr float max_cells = 1 << 20;
+
+  float min_cell_size, cell_size = 1;
+  float origin_x = 0, origin_y = 0;
+  uint32_t columns = 1;
+  std::vector<float> x, y, radius;
+  std::vector<int32_t> cell_x, cell_y;
+  std::vector<uint32_t> bucket, rank;
+  std::vector<Entry> sorted;
+  size_t bucket_count = 0;
+  std::unique_ptr<std::atomic<uint32_t>[]> counts;
+  std::vector<uint32_t> bucket_start;
+  std::vector<std::vector<Pair>> task_pairs;
+  std::vector<Pair> pairs;
+};
+
+template <typename Object> constexpr float BroadPhase<Object>::max_cells;
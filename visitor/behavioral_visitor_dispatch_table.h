@@ -0,0 +1,140 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+// acyclic visitor without RTTI: every node type and every visitor type gets
+// a dense integer id the first time it is mentioned, and each visitor
+// registers one thunk per node type it handles in a table indexed by
+// (visitor id, node id). nodes still know nothing about visitors and
+// visitors only name the node types they care about, so there is no
+// hierarchy coupling in either direction; dispatch is one indexed load
+// and an indirect call instead of a dynamic_cast cross-cast
+
+struct TableVisitor;
+struct TableVisitable;
+
+class DispatchTable
+{
+public:
+  using Thunk = void (*)(TableVisitor&, TableVisitable&);
+
+  static uint32_t next_node_id()
+  {
+    static std::atomic<uint32_t> counter{0};
+    return counter++;
+  }
+
+  static uint32_t next_visitor_id()
+  {
+    static std::atomic<uint32_t> counter{0};
+    return counter++;
+  }
+
+  // rows only change during registration, which happens during static
+  // initialization (see VisitsNodes), so lookups need no locking.
+  // every TableVisitor caches a pointer into its row, which a resize would
+  // leave dangling, so the table is frozen when the first visitor is
+  // constructed and registering after that is an error
+  static std::vector<std::vector<Thunk>>& rows()
+  {
+    static std::vector<std::vector<Thunk>> table;
+    return table;
+  }
+
+  static std::atomic<bool>& frozen()
+  {
+    static std::atomic<bool> value{false};
+    return value;
+  }
+
+  static void add(uint32_t visitor, uint32_t node, Thunk thunk)
+  {
+    assert(!frozen().load(std::memory_order_relaxed) && "visitor registered after the first TableVisitor was constructed");
+    auto& table = rows();
+    if (table.size() <= visitor) table.resize(visitor + 1);
+    if (table[visitor].size() <= node) table[visitor].resize(node + 1, nullptr);
+    table[visitor][node] = thunk;
+  }
+};
+
+template <typename Node> uint32_t node_type_id()
+{
+  static const uint32_t id = DispatchTable::next_node_id();
+  return id;
+}
+
+template <typename Visitor> uint32_t visitor_type_id()
+{
+  static const uint32_t id = DispatchTable::next_visitor_id();
+  return id;
+}
+
+// base of every visitable node; the most derived constructor passes
+// node_type_id<Self>()
+struct TableVisitable
+{
+  uint32_t type_id;
+
+  explicit TableVisitable(uint32_t type_id) : type_id{type_id} {}
+};
+
+struct TableVisitor
+{
+  uint32_t visitor_id;
+  // this visitor's row of the table, cached at construction
+  const DispatchTable::Thunk* row = nullptr;
+  size_t row_size = 0;
+
+  explicit TableVisitor(uint32_t visitor_id) : visitor_id{visitor_id}
+  {
+    auto& frozen = DispatchTable::frozen();
+    if (!frozen.load(std::memory_order_relaxed))
+      frozen.store(true, std::memory_order_relaxed);
+    auto& table = DispatchTable::rows();
+    if (visitor_id < table.size())
+    {
+      row = table[visitor_id].data();
+      row_size = table[visitor_id].size();
+    }
+  }
+};
+
+// nodes a visitor doesn't handle are skipped, like a failed cross-cast
+inline void dispatch(TableVisitor& visitor, TableVisitable& node)
+{
+  if (node.type_id < visitor.row_size)
+    if (auto thunk = visitor.row[node.type_id])
+      thunk(visitor, node);
+}
+
+// CRTP base: `struct Printer : VisitsNodes<Printer, A, B>` gets its visit(A&)
+// and visit(B&) registered before main() runs
+template <typename Derived, typename... Nodes>
+struct VisitsNodes : TableVisitor
+{
+  VisitsNodes() : TableVisitor{((void)registered, visitor_type_id<Derived>())} {}
+
+private:
+  template <typename Node> static void thunk(TableVisitor& v, TableVisitable& n)
+  {
+    static_cast<Derived&>(v).visit(static_cast<Node&>(n));
+  }
+
+  static bool register_all()
+  {
+    auto id = visitor_type_id<Derived>();
+    (void)std::initializer_list<int>{
+      (DispatchTable::add(id, node_type_id<Nodes>(), &thunk<Nodes>), 0)...
+    };
+    return true;
+  }
+
+  static const bool registered;
+};
+
+template <typename Derived, typename... Nodes>
+const bool VisitsNodes<Derived, Nodes...>::registered = VisitsNodes<Derived, Nodes...>::register_all();
@@ -2,8 +2,19 @@
 #include <sstream>
 #include <string>
 #include <iostream>
+#include <vector>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
 using namespace std;
 
+#include "../common/work_stealing_pool.h"
+#include "behavioral_visitor_text_buffer.h"
+
 struct SubtractionExpression;
 struct DoubleExpression;
 struct AdditionExpression;
@@ -34,6 +45,7 @@ struct ExpressionEvaluator : ExpressionVisitor
 
 struct Expression
 {
+  virtual ~Expression() = default;
   virtual void accept(ExpressionVisitor* visitor) = 0;
 };
 
@@ -130,7 +142,7 @@ void ExpressionEvaluator::visit(SubtractionExpression* se)
   se->left->accept(this);
   auto temp = result;
   se->right->accept(this);
-  result -= temp;
+  result = temp - result;
 }
 
 int main_visitor_double()
@@ -151,3 +163,726 @@ int main_visitor_double()
   getchar();
   return 0;
 }
+
+// flattened form: the tree in postorder, one opcode byte per node and the
+// literals in a separate array, evaluated by streaming through both with an
+// explicit value stack - no virtual calls, no pointer chasing
+struct FlatExpression
+{
+  enum Op : uint8_t { literal, add, subtract };
+
+  vector<Op> ops;
+  vector<double> literals; // one per `literal` op, in the same order
+  size_t max_stack = 0;
+
+  double evaluate(vector<double>& stack) const
+  {
+    if (stack.size() < max_stack)
+      stack.resize(max_stack);
+    double* sp = stack.data();
+    const double* next_literal = literals.data();
+
+    for (auto op : ops)
+    {
+      switch (op)
+      {
+      case literal: *sp++ = *next_literal++; break;
+      case add: --sp; sp[-1] += *sp; break;
+      case subtract: --sp; sp[-1] -= *sp; break;
+      }
+    }
+    return sp[-1];
+  }
+};
+
+// builds a FlatExpression with an ordinary visitor
+struct ExpressionFlattener : ExpressionVisitor
+{
+  FlatExpression result;
+  size_t depth = 0;
+
+  void visit(DoubleExpression* de) override
+  {
+    result.ops.push_back(FlatExpression::literal);
+    result.literals.push_back(de->value);
+    result.max_stack = max(result.max_stack, ++depth);
+  }
+
+  void visit(AdditionExpression* ae) override { binary(ae->left, ae->right, FlatExpression::add); }
+  void visit(SubtractionExpression* se) override { binary(se->left, se->right, FlatExpression::subtract); }
+
+private:
+  void binary(Expression* left, Expression* right, FlatExpression::Op op)
+  {
+    left->accept(this);
+    right->accept(this);
+    result.ops.push_back(op);
+    --depth;
+  }
+};
+
+namespace
+{
+  // random shape, random operators; nodes are allocated in visiting order,
+  // interleaved with other allocations (as in a long-lived program) if
+  // `noise` is given
+  Expression* random_tree(size_t leaves, mt19937& rng, vector<unique_ptr<char[]>>* noise)
+  {
+    if (noise)
+      noise->emplace_back(new char[rng() % 64 + 1]);
+    if (leaves == 1)
+      return new DoubleExpression{ static_cast<double>(rng() % 10) };
+    auto left = 1 + rng() % (leaves - 1);
+    auto l = random_tree(left, rng, noise);
+    auto r = random_tree(leaves - left, rng, noise);
+    if (rng() & 1) return new AdditionExpression{ l, r };
+    return new SubtractionExpression{ l, r };
+  }
+}
+
+int main_visitor_flatten()
+{
+  mt19937 rng{ 1 };
+  vector<unique_ptr<char[]>> noise;
+  auto e = random_tree(2000000, rng, &noise);
+  noise.clear();
+
+  ExpressionFlattener flattener;
+  e->accept(&flattener);
+  auto& flat = flattener.result;
+  cout << flat.ops.size() << " nodes flattened into "
+    << flat.ops.size() * sizeof(FlatExpression::Op) + flat.literals.size() * sizeof(double)
+    << " bytes, max stack " << flat.max_stack << "\n";
+
+  const int passes = 10;
+  ExpressionEvaluator evaluator;
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < passes; ++i)
+    e->accept(&evaluator);
+  chrono::duration<double, nano> tree_time = chrono::steady_clock::now() - start;
+
+  vector<double> stack;
+  double flat_result = 0;
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < passes; ++i)
+    flat_result = flat.evaluate(stack);
+  chrono::duration<double, nano> flat_time = chrono::steady_clock::now() - start;
+
+  auto visits = static_cast<double>(flat.ops.size()) * passes;
+  cout << "visitor:   " << tree_time.count() / visits << " ns/node = " << evaluator.result << "\n"
+    << "flattened: " << flat_time.count() / visits << " ns/node = " << flat_result << "\n";
+
+  delete e;
+  return 0;
+}
+
+// parallel traversal for visitors whose result for a node depends only on
+// the results for its children (evaluation, counting, ...). the Fold
+// supplies the per-node functions:
+//   Result leaf(DoubleExpression*)
+//   Result combine(AdditionExpression*, Result left, Result right)
+//   Result combine(SubtractionExpression*, Result left, Result right)
+// in the top fork_depth levels of the tree the left child is visited as a
+// pool task while this thread takes the right one; below that the walk is
+// serial. nodes don't know their subtree sizes, so the cut-off is a depth,
+// chosen deep enough that lopsided trees still leave plenty of tasks to steal
+template <typename Fold> struct ParallelVisitor : ExpressionVisitor
+{
+  using Result = typename Fold::Result;
+  Result result{};
+
+  ParallelVisitor(WorkStealingPool& pool, int fork_depth, Fold fold = Fold{})
+    : pool{ pool }, fork_depth{ fork_depth }, fold{ fold } {}
+
+  // about a hundred tasks per worker
+  explicit ParallelVisitor(WorkStealingPool& pool, Fold fold = Fold{})
+    : ParallelVisitor{ pool, default_fork_depth(pool), fold } {}
+
+  void visit(DoubleExpression* de) override { result = fold.leaf(de); }
+  void visit(AdditionExpression* ae) override { binary(ae); }
+  void visit(SubtractionExpression* se) override { binary(se); }
+
+private:
+  static int default_fork_depth(const WorkStealingPool& pool)
+  {
+    int depth = 7;
+    for (auto n = pool.size(); n > 1; n /= 2)
+      ++depth;
+    return depth;
+  }
+
+  template <typename Node> void binary(Node* node)
+  {
+    Result left, right;
+    if (fork_depth > 0)
+    {
+      ParallelVisitor left_visitor{ pool, fork_depth - 1, fold };
+      TaskGroup group{ pool };
+      group.run([&] { node->left->accept(&left_visitor); });
+      --fork_depth;
+      node->right->accept(this);
+      ++fork_depth;
+      right = result;
+      group.wait();
+      left = left_visitor.result;
+    }
+    else
+    {
+      node->left->accept(this);
+      left = result;
+      node->right->accept(this);
+      right = result;
+    }
+    result = fold.combine(node, left, right);
+  }
+
+  WorkStealingPool& pool;
+  int fork_depth;
+  Fold fold;
+};
+
+struct EvaluationFold
+{
+  using Result = double;
+
+  double leaf(DoubleExpression* de) const { return de->value; }
+  double combine(AdditionExpression*, double left, double right) const { return left + right; }
+  double combine(SubtractionExpression*, double left, double right) const { return left - right; }
+};
+
+struct TreeShape
+{
+  size_t nodes, leaves, height;
+};
+
+struct ShapeFold
+{
+  using Result = TreeShape;
+
+  TreeShape leaf(DoubleExpression*) const { return { 1, 1, 1 }; }
+  TreeShape combine(Expression*, TreeShape left, TreeShape right) const
+  {
+    return { left.nodes + right.nodes + 1, left.leaves + right.leaves, max(left.height, right.height) + 1 };
+  }
+};
+
+// usage: main_visitor_parallel(argc, argv) with argv[1] = number of leaves;
+// a tree with 10^8 nodes (5 * 10^7 leaves) needs about 4 GB
+int main_visitor_parallel(int argc, char* argv[])
+{
+  size_t leaves = argc > 1 ? stoull(argv[1]) : 1 << 23;
+  mt19937 rng{ 2 };
+  auto start = chrono::steady_clock::now();
+  auto e = random_tree(leaves, rng, nullptr);
+  chrono::duration<double> build = chrono::steady_clock::now() - start;
+
+  {
+    WorkStealingPool pool;
+    ParallelVisitor<ShapeFold> shape{ pool };
+    e->accept(&shape);
+    cout << shape.result.nodes << " nodes, " << shape.result.leaves << " leaves, height "
+      << shape.result.height << ", built in " << build.count() << " s\n";
+  }
+
+  ExpressionEvaluator serial;
+  start = chrono::steady_clock::now();
+  e->accept(&serial);
+  chrono::duration<double, milli> serial_time = chrono::steady_clock::now() - start;
+  cout << "serial:    " << serial_time.count() << " ms = " << serial.result << "\n";
+
+  auto cores = max(1u, thread::hardware_concurrency());
+  for (unsigned threads = 1; ; threads = min(threads * 2, cores))
+  {
+    WorkStealingPool pool{ threads };
+    ParallelVisitor<EvaluationFold> parallel{ pool };
+    start = chrono::steady_clock::now();
+    e->accept(&parallel);
+    chrono::duration<double, milli> time = chrono::steady_clock::now() - start;
+    cout << threads << " threads: " << time.count() << " ms = " << parallel.result
+      << ", speedup " << serial_time.count() / time.count() << "x\n";
+    if (threads == cores) break;
+  }
+
+  delete e;
+  return 0;
+}
+
+// walks a tree of any depth without running out of stack. the first
+// `recursion_limit` levels are walked recursively, which costs nothing
+// extra and covers any balanced tree; below that the walk continues on an
+// explicit stack on the heap, so machine stack use is bounded by the limit
+// and heap use by the depth of the tree. Hooks gets
+//   pre(node)   before a node's children
+//   in(node)    between the two children of a binary node
+//   post(node)  after the children
+// called with the concrete node type, so the hooks are bound statically and
+// the only virtual call per node is the accept() that tells the walker what
+// kind of node it is looking at. derive hooks from WalkHooks to get no-op
+// defaults for the ones you don't need
+template <typename Hooks> class ExpressionWalker : ExpressionVisitor
+{
+public:
+  explicit ExpressionWalker(Hooks& hooks, int recursion_limit = 256)
+    : hooks{ hooks }, recursion_limit{ recursion_limit } {}
+
+  void walk(Expression* root)
+  {
+    depth = 0;
+    root->accept(this);
+  }
+
+private:
+  struct Frame
+  {
+    Expression* node;
+    enum Step : uint8_t { addition_in, addition_post, subtraction_in, subtraction_post } step;
+  };
+
+  void visit(DoubleExpression* de) override
+  {
+    hooks.pre(de);
+    hooks.post(de);
+  }
+
+  void visit(AdditionExpression* ae) override { binary(ae, Frame::addition_in); }
+  void visit(SubtractionExpression* se) override { binary(se, Frame::subtraction_in); }
+
+  template <typename Node> void binary(Node* node, typename Frame::Step in)
+  {
+    hooks.pre(node);
+    if (depth < recursion_limit)
+    {
+      ++depth;
+      node->left->accept(this);
+      hooks.in(node);
+      node->right->accept(this);
+      hooks.post(node);
+      --depth;
+      return;
+    }
+
+    stack.push_back({ node, in });
+    next = node->left;
+    if (!iterating)
+    {
+      iterating = true;
+      iterate();
+      iterating = false;
+    }
+  }
+
+  // goes down left edges without touching the stack; a binary node leaves
+  // one frame behind, which is revisited once its left subtree is done (to
+  // go right) and once more after its right subtree
+  void iterate()
+  {
+    while (true)
+    {
+      while (next)
+      {
+        auto node = next;
+        next = nullptr;
+        node->accept(this);
+      }
+      if (stack.empty())
+        return;
+
+      auto& frame = stack.back();
+      switch (frame.step)
+      {
+      case Frame::addition_in: go_right(static_cast<AdditionExpression*>(frame.node), frame, Frame::addition_post); break;
+      case Frame::subtraction_in: go_right(static_cast<SubtractionExpression*>(frame.node), frame, Frame::subtraction_post); break;
+      case Frame::addition_post: finish(static_cast<AdditionExpression*>(frame.node)); break;
+      case Frame::subtraction_post: finish(static_cast<SubtractionExpression*>(frame.node)); break;
+      }
+    }
+  }
+
+  template <typename Node> void go_right(Node* node, Frame& frame, typename Frame::Step post)
+  {
+    hooks.in(node);
+    frame.step = post;
+    next = node->right;
+  }
+
+  template <typename Node> void finish(Node* node)
+  {
+    stack.pop_back(); // before the hook, which may delete the node
+    hooks.post(node);
+  }
+
+  Hooks& hooks;
+  int recursion_limit, depth = 0;
+  bool iterating = false;
+  Expression* next = nullptr;
+  vector<Frame> stack; // kept between walks
+};
+
+struct WalkHooks
+{
+  template <typename Node> void pre(Node*) {}
+  template <typename Node> void in(Node*) {}
+  template <typename Node> void post(Node*) {}
+};
+
+// like ExpressionEvaluator: the latest value is in `result`, and the left
+// operands waiting for their right-hand side are on a stack
+struct WalkingEvaluator : WalkHooks
+{
+  using WalkHooks::post;
+  double result = 0;
+  vector<double> left_values;
+
+  void post(DoubleExpression* de) { result = de->value; }
+  template <typename Node> void in(Node*) { left_values.push_back(result); }
+  void post(AdditionExpression*) { result = take_left() + result; }
+  void post(SubtractionExpression*) { result = take_left() - result; }
+
+private:
+  double take_left()
+  {
+    auto left = left_values.back();
+    left_values.pop_back();
+    return left;
+  }
+};
+
+struct WalkingPrinter : WalkHooks
+{
+  using WalkHooks::pre;
+  using WalkHooks::post;
+  ostringstream oss;
+
+  void pre(DoubleExpression* de) { oss << de->value; }
+  void pre(AdditionExpression*) { oss << "("; }
+  void pre(SubtractionExpression*) { oss << "("; }
+  void in(AdditionExpression*) { oss << "+"; }
+  void in(SubtractionExpression*) { oss << "-"; }
+  void post(AdditionExpression*) { oss << ")"; }
+  void post(SubtractionExpression*) { oss << ")"; }
+};
+
+// deletes bottom-up; the children are gone by the time a parent's post()
+// runs, so the parent's links are cleared first and its destructor has
+// nothing left to recurse into
+struct ExpressionDeleter : WalkHooks
+{
+  void post(DoubleExpression* de) { delete de; }
+
+  template <typename Node> void post(Node* node)
+  {
+    node->left = node->right = nullptr;
+    delete node;
+  }
+};
+
+int main_visitor_iterative()
+{
+  // left-deep chain; the recursive visitors would run out of stack on this
+  const int length = 1000000;
+  Expression* chain = new DoubleExpression{ 0 };
+  for (int i = 1; i <= length; ++i)
+    chain = new AdditionExpression{ chain, new DoubleExpression{ 1 } };
+
+  WalkingEvaluator evaluator;
+  ExpressionWalker<WalkingEvaluator> evaluate{ evaluator };
+  evaluate.walk(chain);
+  WalkingPrinter printer;
+  ExpressionWalker<WalkingPrinter> print{ printer };
+  print.walk(chain);
+  auto text = printer.oss.str();
+  cout << "chain of " << length << " additions = " << evaluator.result
+    << ", printed as " << text.substr(0, 10) << "..." << text.substr(text.size() - 10)
+    << " (" << text.size() << " chars)\n";
+
+  ExpressionDeleter deleter;
+  ExpressionWalker<ExpressionDeleter> destroy{ deleter };
+  destroy.walk(chain);
+
+  // balanced tree: the explicit stack against the call stack
+  mt19937 rng{ 4 };
+  auto tree = random_tree(1 << 21, rng, nullptr);
+  const int passes = 10;
+
+  ExpressionEvaluator recursive;
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < passes; ++i)
+    tree->accept(&recursive);
+  chrono::duration<double, milli> recursive_time = chrono::steady_clock::now() - start;
+
+  cout << "random tree, " << passes << " passes: recursive visitor " << recursive_time.count()
+    << " ms = " << recursive.result << "\n";
+
+  for (int limit : { 256, 0 })
+  {
+    ExpressionWalker<WalkingEvaluator> walker{ evaluator, limit };
+    double walked = 0;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < passes; ++i)
+    {
+      walker.walk(tree);
+      walked = evaluator.result;
+    }
+    chrono::duration<double, milli> walk_time = chrono::steady_clock::now() - start;
+    cout << "  walker, recursion limit " << limit << ": " << walk_time.count() << " ms = " << walked << "\n";
+  }
+
+  destroy.walk(tree);
+  return 0;
+}
+
+// WalkingPrinter's output, written into a TextBuffer instead of a stream
+struct BufferPrinter : WalkHooks
+{
+  using WalkHooks::post;
+  TextBuffer& out;
+
+  explicit BufferPrinter(TextBuffer& out) : out{ out } {}
+
+  void pre(DoubleExpression* de) { out.put(de->value); }
+  void pre(AdditionExpression*) { out.put('('); }
+  void pre(SubtractionExpression*) { out.put('('); }
+  void in(AdditionExpression*) { out.put('+'); }
+  void in(SubtractionExpression*) { out.put('-'); }
+  void post(AdditionExpression*) { out.put(')'); }
+  void post(SubtractionExpression*) { out.put(')'); }
+};
+
+namespace
+{
+  // replaces `out` with the printed expression: a measuring pass finds the
+  // length, then the text is written straight into the string's storage,
+  // so the string is allocated at most once and nothing is copied
+  void print_expression(Expression* e, string& out)
+  {
+    auto measure = TextBuffer::measuring();
+    BufferPrinter measuring_printer{ measure };
+    ExpressionWalker<BufferPrinter>{ measuring_printer }.walk(e);
+    out.resize(measure.size());
+    TextBuffer span{ &out[0], out.size() };
+    BufferPrinter printer{ span };
+    ExpressionWalker<BufferPrinter>{ printer }.walk(e);
+  }
+}
+
+int main_visitor_buffer_print()
+{
+  mt19937 rng{ 6 };
+  auto tree = random_tree(1 << 21, rng, nullptr);
+  const int passes = 5;
+  auto mb_per_second = [](size_t bytes, chrono::duration<double> time) {
+    return bytes / time.count() / 1e6;
+  };
+
+  string streamed;
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < passes; ++i)
+  {
+    WalkingPrinter printer;
+    ExpressionWalker<WalkingPrinter>{ printer }.walk(tree);
+    streamed = printer.oss.str();
+  }
+  chrono::duration<double> stream_time = chrono::steady_clock::now() - start;
+
+  // reused growable buffer: allocates on the first pass only
+  TextBuffer buffer;
+  BufferPrinter buffer_printer{ buffer };
+  ExpressionWalker<BufferPrinter> walker{ buffer_printer };
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < passes; ++i)
+  {
+    buffer.clear();
+    walker.walk(tree);
+  }
+  chrono::duration<double> buffer_time = chrono::steady_clock::now() - start;
+
+  // measured, then printed straight into the caller's string
+  string exact;
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < passes; ++i)
+    print_expression(tree, exact);
+  chrono::duration<double> exact_time = chrono::steady_clock::now() - start;
+
+  // the floors: walking the tree without output, and copying the text
+  WalkHooks nothing;
+  ExpressionWalker<WalkHooks> bare_walker{ nothing };
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < passes; ++i)
+    bare_walker.walk(tree);
+  chrono::duration<double> walk_time = chrono::steady_clock::now() - start;
+
+  vector<char> copy(streamed.size());
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < passes; ++i)
+    memcpy(copy.data(), streamed.data(), streamed.size());
+  chrono::duration<double> copy_time = chrono::steady_clock::now() - start;
+
+  auto bytes = streamed.size() * passes;
+  cout << streamed.size() << " chars per print, MB/s:\n"
+    << "  ostringstream:           " << mb_per_second(bytes, stream_time) << "\n"
+    << "  reused buffer:           " << mb_per_second(bytes, buffer_time)
+    << (buffer.str() == streamed ? "" : " (OUTPUT DIFFERS)") << "\n"
+    << "  measured, caller's span: " << mb_per_second(bytes, exact_time)
+    << (exact == streamed ? "" : " (OUTPUT DIFFERS)") << "\n"
+    << "  walk without output:     " << mb_per_second(bytes, walk_time) << "\n"
+    << "  memcpy:                  " << mb_per_second(bytes, copy_time) << "\n";
+
+  ExpressionDeleter deleter;
+  ExpressionWalker<ExpressionDeleter>{ deleter }.walk(tree);
+  return 0;
+}
+
+// keeps every node's value between evaluations, so changing a few leaves
+// costs the length of their paths to the root instead of a full walk.
+// the per-node state - cached value, parent, children, dirty flag - lives
+// in a table built once by walking the tree, numbered in postorder so that
+// children always come before their parents; recomputing the dirty nodes
+// in index order is then a valid bottom-up order. the tree's shape must not
+// change while the evaluator is in use, only leaf values
+class IncrementalEvaluator
+{
+public:
+  explicit IncrementalEvaluator(Expression* root)
+  {
+    Builder builder{ *this };
+    ExpressionWalker<Builder>{ builder }.walk(root);
+  }
+
+  // changes the leaf and marks the path above it; stops at the first
+  // ancestor that is already dirty, since the rest of that path is too
+  void set(DoubleExpression* leaf, double value)
+  {
+    leaf->value = value;
+    auto i = leaf_slots.at(leaf);
+    nodes[i].value = value;
+    for (auto p = nodes[i].parent; p != none && !nodes[p].dirty; p = nodes[p].parent)
+    {
+      nodes[p].dirty = true;
+      dirty.push_back(p);
+    }
+  }
+
+  double result()
+  {
+    sort(dirty.begin(), dirty.end());
+    for (auto i : dirty)
+    {
+      auto& n = nodes[i];
+      auto left = nodes[n.left].value, right = nodes[n.right].value;
+      n.value = n.kind == Node::addition ? left + right : left - right;
+      n.dirty = false;
+    }
+    last_recomputed = dirty.size();
+    dirty.clear();
+    return nodes.back().value;
+  }
+
+  size_t size() const { return nodes.size(); }
+  size_t recomputed() const { return last_recomputed; } // by the last result()
+
+private:
+  static constexpr uint32_t none = UINT32_MAX;
+
+  struct Node
+  {
+    double value;
+    uint32_t parent, left, right;
+    enum Kind : uint8_t { leaf, addition, subtraction } kind;
+    bool dirty;
+  };
+
+  // postorder numbering; the slots of finished subtrees wait on a stack
+  // until their parent is reached
+  struct Builder : WalkHooks
+  {
+    IncrementalEvaluator& self;
+    vector<uint32_t> pending;
+
+    explicit Builder(IncrementalEvaluator& self) : self{ self } {}
+
+    void post(DoubleExpression* de)
+    {
+      self.leaf_slots[de] = add({ de->value, none, none, none, Node::leaf, false });
+    }
+
+    void post(AdditionExpression*) { binary(Node::addition); }
+    void post(SubtractionExpression*) { binary(Node::subtraction); }
+
+  private:
+    void binary(Node::Kind kind)
+    {
+      auto right = pending.back();
+      pending.pop_back();
+      auto left = pending.back();
+      pending.pop_back();
+      auto& nodes = self.nodes;
+      auto value = kind == Node::addition ? nodes[left].value + nodes[right].value : nodes[left].value - nodes[right].value;
+      auto i = add({ value, none, left, right, kind, false });
+      nodes[left].parent = nodes[right].parent = i;
+    }
+
+    uint32_t add(Node node)
+    {
+      self.nodes.push_back(node);
+      auto i = static_cast<uint32_t>(self.nodes.size() - 1);
+      pending.push_back(i);
+      return i;
+    }
+  };
+
+  vector<Node> nodes;
+  unordered_map<DoubleExpression*, uint32_t> leaf_slots;
+  vector<uint32_t> dirty;
+  size_t last_recomputed = 0;
+};
+
+struct LeafCollector : WalkHooks
+{
+  using WalkHooks::pre;
+  vector<DoubleExpression*> leaves;
+
+  void pre(DoubleExpression* de) { leaves.push_back(de); }
+};
+
+int main_visitor_incremental()
+{
+  mt19937 rng{ 8 };
+  auto tree = random_tree(1 << 21, rng, nullptr);
+  LeafCollector collector;
+  ExpressionWalker<LeafCollector>{ collector }.walk(tree);
+  auto& leaves = collector.leaves;
+
+  auto start = chrono::steady_clock::now();
+  IncrementalEvaluator incremental{ tree };
+  chrono::duration<double, milli> build_time = chrono::steady_clock::now() - start;
+  cout << incremental.size() << " nodes, evaluator built in " << build_time.count() << " ms\n";
+
+  // spreadsheet-style: a handful of cells change, then the total is read
+  const int updates = 10000, cells_per_update = 5, full_walks = 10;
+  size_t recomputed = 0;
+  double incremental_result = 0;
+  start = chrono::steady_clock::now();
+  for (int u = 0; u < updates; ++u)
+  {
+    for (int c = 0; c < cells_per_update; ++c)
+      incremental.set(leaves[rng() % leaves.size()], static_cast<double>(rng() % 10));
+    incremental_result = incremental.result();
+    recomputed += incremental.recomputed();
+  }
+  chrono::duration<double, micro> incremental_time = chrono::steady_clock::now() - start;
+
+  ExpressionEvaluator full;
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < full_walks; ++i)
+    tree->accept(&full);
+  chrono::duration<double, micro> full_time = chrono::steady_clock::now() - start;
+
+  cout << "per update of " << cells_per_update << " leaves: incremental "
+    << incremental_time.count() / updates << " us (" << recomputed / updates
+    << " nodes recomputed), full walk " << full_time.count() / full_walks << " us\n"
+    << "results: " << incremental_result << " and " << full.result << "\n";
+
+  ExpressionDeleter deleter;
+  ExpressionWalker<ExpressionDeleter>{ deleter }.walk(tree);
+  return 0;
+}
@@ -3,15 +3,43 @@
 #include <typeindex>
 #include <map>
 #include <functional>
+#include <vector>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
 using namespace std;
 
+#include "../common/work_stealing_pool.h"
+#include "behavioral_visitor_broad_phase.h"
+
 struct GameObject;
 void collide(GameObject& first, GameObject& second);
 
+// dense ids for the matrix below, assigned on first use
+inline uint32_t next_collision_type_id()
+{
+	static atomic<uint32_t> counter{ 0 };
+	return counter++;
+}
+
+template <typename T> uint32_t collision_type_id()
+{
+	static const uint32_t id = next_collision_type_id();
+	return id;
+}
+
 struct GameObject
 {
 	virtual ~GameObject() = default;
 	virtual type_index type() const = 0;
+	virtual uint32_t type_id() const = 0;
+
+	// position and bounding circle, for the broad phase
+	float x = 0, y = 0, radius = 0;
 
 	virtual void collide(GameObject& other) { ::collide(*this, other); }
 };
@@ -22,6 +50,11 @@ template <typename T> struct GameObjectImpl : GameObject
 	{
 		return typeid(T);
 	}
+
+	uint32_t type_id() const override
+	{
+		return collision_type_id<T>();
+	}
 };
 
 struct Planet : GameObjectImpl<Planet> {};
@@ -32,6 +65,10 @@ struct ArmedSpaceship : Spaceship
 	type_index type() const override {
 		return typeid(ArmedSpaceship); // required for collision to function
 	}
+
+	uint32_t type_id() const override {
+		return collision_type_id<ArmedSpaceship>();
+	}
 }; // model limitation
 
 void spaceship_planet() { cout << "spaceship lands on planet\n"; }
@@ -81,3 +118,322 @@ int main__(int argc, char* argv[])
 	getchar();
 	return 0;
 }
+
+// the same dispatch as collide(), but the outcomes live in an N x N matrix
+// indexed by the dense type ids, so a lookup is one load instead of up to
+// two map searches. each cell also records whether the handler was
+// registered for the mirrored pair, so both orders are found at once
+class CollisionMatrix
+{
+public:
+	using Handler = void(*)(GameObject&, GameObject&);
+
+	using Pair = pair<GameObject*, GameObject*>;
+
+	explicit CollisionMatrix(Handler fallback) : fallback{ fallback } {}
+
+	// the mirrored cell is filled too, unless it has a handler of its own
+	template <typename First, typename Second> void add(Handler handler)
+	{
+		auto a = collision_type_id<First>(), b = collision_type_id<Second>();
+		grow(max(a, b) + 1);
+		cells[a * n + b] = { handler, false };
+		if (a != b && !cells[b * n + a].handler)
+			cells[b * n + a] = { handler, true };
+	}
+
+	void collide(GameObject& first, GameObject& second) const
+	{
+		invoke(cell(first.type_id(), second.type_id()), first, second);
+	}
+
+	// resolves every pair; pairs are bucketed by their type pair first
+	// (counting sort over the cells) so each handler runs over all of its
+	// pairs in one go, with a predictable indirect call
+	void collide_all(const Pair* pairs, size_t count)
+	{
+		const size_t cell_count = n * n + 1; // the last bucket is "no handler"
+		bucket_start.assign(cell_count + 1, 0);
+		keys.resize(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+#ifdef __GNUC__
+			// the objects are scattered over the heap; fetch a few pairs ahead
+			if (i + 16 < count)
+			{
+				__builtin_prefetch(pairs[i + 16].first);
+				__builtin_prefetch(pairs[i + 16].second);
+			}
+#endif
+			keys[i] = key(pairs[i].first->type_id(), pairs[i].second->type_id());
+			++bucket_start[keys[i] + 1];
+		}
+		for (size_t k = 0; k < cell_count; ++k)
+			bucket_start[k + 1] += bucket_start[k];
+
+		sorted.resize(count);
+		auto next = bucket_start;
+		for (size_t i = 0; i < count; ++i)
+			sorted[next[keys[i]]++] = pairs[i];
+
+		for (size_t k = 0; k < cell_count; ++k)
+		{
+			auto c = k < n * n ? cells[k] : Cell{ fallback, false };
+			if (!c.handler) c = { fallback, false };
+			for (auto i = bucket_start[k]; i < bucket_start[k + 1]; ++i)
+				invoke(c, *sorted[i].first, *sorted[i].second);
+		}
+	}
+
+private:
+	struct Cell
+	{
+		Handler handler;
+		bool swapped;
+	};
+
+	void grow(size_t size)
+	{
+		if (size <= n) return;
+		vector<Cell> bigger(size * size, Cell{ nullptr, false });
+		for (size_t a = 0; a < n; ++a)
+			for (size_t b = 0; b < n; ++b)
+				bigger[a * size + b] = cells[a * n + b];
+		cells.swap(bigger);
+		n = size;
+	}
+
+	uint32_t key(uint32_t a, uint32_t b) const
+	{
+		return a < n && b < n ? a * static_cast<uint32_t>(n) + b : static_cast<uint32_t>(n * n);
+	}
+
+	Cell cell(uint32_t a, uint32_t b) const
+	{
+		auto k = key(a, b);
+		if (k == n * n || !cells[k].handler) return { fallback, false };
+		return cells[k];
+	}
+
+	static void invoke(Cell c, GameObject& first, GameObject& second)
+	{
+		if (c.swapped) c.handler(second, first);
+		else c.handler(first, second);
+	}
+
+	Handler fallback;
+	vector<Cell> cells;
+	size_t n = 0;
+	// scratch space for collide_all, kept between frames
+	vector<uint32_t> keys;
+	vector<size_t> bucket_start;
+	vector<Pair> sorted;
+};
+
+namespace
+{
+	size_t outcome_counts[5];
+
+	template <int Outcome> void count_outcome(GameObject&, GameObject&) { ++outcome_counts[Outcome]; }
+
+	// the map from collide(), with counting handlers instead of printing ones
+	map<pair<type_index, type_index>, void(*)(void)> counting_outcomes{
+		{{typeid(Spaceship), typeid(Planet)}, [] { ++outcome_counts[0]; }},
+		{{typeid(Asteroid),typeid(Planet)}, [] { ++outcome_counts[1]; }},
+		{{typeid(Asteroid),typeid(Spaceship)}, [] { ++outcome_counts[2]; }},
+		{{typeid(Asteroid), typeid(ArmedSpaceship)}, [] { ++outcome_counts[3]; }}
+	};
+
+	void map_collide(GameObject& first, GameObject& second)
+	{
+		auto it = counting_outcomes.find({ first.type(), second.type() });
+		if (it == counting_outcomes.end())
+		{
+			it = counting_outcomes.find({ second.type(), first.type() });
+			if (it == counting_outcomes.end())
+			{
+				++outcome_counts[4];
+				return;
+			}
+		}
+		it->second();
+	}
+
+	template <typename F> double nanoseconds_per_pair(F f, size_t pairs)
+	{
+		fill(begin(outcome_counts), end(outcome_counts), 0);
+		auto start = chrono::steady_clock::now();
+		f();
+		return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / pairs;
+	}
+}
+
+int main_multimethods_matrix()
+{
+	CollisionMatrix matrix{ [](GameObject&, GameObject&) { cout << "objects pass each other harmlessly\n"; } };
+	matrix.add<Spaceship, Planet>([](GameObject&, GameObject&) { spaceship_planet(); });
+	matrix.add<Asteroid, Planet>([](GameObject&, GameObject&) { asteroid_planet(); });
+	matrix.add<Asteroid, Spaceship>([](GameObject&, GameObject&) { asteroid_spaceship(); });
+	matrix.add<Asteroid, ArmedSpaceship>([](GameObject&, GameObject&) { asteroid_armed_spaceship(); });
+
+	ArmedSpaceship spaceship;
+	Asteroid asteroid;
+	Planet planet;
+
+	matrix.collide(planet, spaceship);
+	matrix.collide(planet, asteroid);
+	matrix.collide(spaceship, asteroid);
+	matrix.collide(planet, planet);
+
+	// a physics frame's worth of candidate pairs over a mixed population
+	CollisionMatrix counting{ count_outcome<4> };
+	counting.add<Spaceship, Planet>(count_outcome<0>);
+	counting.add<Asteroid, Planet>(count_outcome<1>);
+	counting.add<Asteroid, Spaceship>(count_outcome<2>);
+	counting.add<Asteroid, ArmedSpaceship>(count_outcome<3>);
+
+	mt19937 rng{ 5 };
+	vector<unique_ptr<GameObject>> objects;
+	for (int i = 0; i < 100000; ++i)
+	{
+		switch (rng() % 4)
+		{
+		case 0: objects.emplace_back(new Planet); break;
+		case 1: objects.emplace_back(new Asteroid); break;
+		case 2: objects.emplace_back(new Spaceship); break;
+		default: objects.emplace_back(new ArmedSpaceship); break;
+		}
+	}
+	vector<CollisionMatrix::Pair> pairs(4000000);
+	for (auto& p : pairs)
+		p = { objects[rng() % objects.size()].get(), objects[rng() % objects.size()].get() };
+
+	auto map_time = nanoseconds_per_pair([&] {
+		for (auto& p : pairs) map_collide(*p.first, *p.second);
+	}, pairs.size());
+	auto map_landings = outcome_counts[0];
+
+	auto matrix_time = nanoseconds_per_pair([&] {
+		for (auto& p : pairs) counting.collide(*p.first, *p.second);
+	}, pairs.size());
+	auto matrix_landings = outcome_counts[0];
+
+	auto batch_time = nanoseconds_per_pair([&] {
+		counting.collide_all(pairs.data(), pairs.size());
+	}, pairs.size());
+	auto batch_landings = outcome_counts[0];
+
+	cout << pairs.size() << " pairs, ns/pair: map " << map_time << ", matrix " << matrix_time
+		<< ", batched matrix " << batch_time
+		<< (map_landings == matrix_landings && matrix_landings == batch_landings ? "" : " (RESULTS DIFFER)")
+		<< "\n";
+	return 0;
+}
+
+namespace
+{
+	void scatter(vector<unique_ptr<GameObject>>& objects, size_t count, float world, mt19937& rng)
+	{
+		uniform_real_distribution<float> position(0, world), radius(0.25f, 1.0f);
+		for (size_t i = 0; i < count; ++i)
+		{
+			switch (rng() % 4)
+			{
+			case 0: objects.emplace_back(new Planet); break;
+			case 1: objects.emplace_back(new Asteroid); break;
+			case 2: objects.emplace_back(new Spaceship); break;
+			default: objects.emplace_back(new ArmedSpaceship); break;
+			}
+			objects.back()->x = position(rng);
+			objects.back()->y = position(rng);
+			objects.back()->radius = radius(rng);
+		}
+	}
+
+	size_t brute_force_pairs(const vector<GameObject*>& objects)
+	{
+		size_t pairs = 0;
+		for (size_t i = 0; i < objects.size(); ++i)
+			for (size_t j = i + 1; j < objects.size(); ++j)
+			{
+				auto dx = objects[i]->x - objects[j]->x, dy = objects[i]->y - objects[j]->y;
+				auto r = objects[i]->radius + objects[j]->radius;
+				pairs += dx * dx + dy * dy < r * r;
+			}
+		return pairs;
+	}
+}
+
+int main_multimethods_broad_phase()
+{
+	CollisionMatrix matrix{ count_outcome<4> };
+	matrix.add<Spaceship, Planet>(count_outcome<0>);
+	matrix.add<Asteroid, Planet>(count_outcome<1>);
+	matrix.add<Asteroid, Spaceship>(count_outcome<2>);
+	matrix.add<Asteroid, ArmedSpaceship>(count_outcome<3>);
+
+	WorkStealingPool pool;
+	BroadPhase<GameObject> broad_phase;
+	mt19937 rng{ 11 };
+
+	// small scenes, down to fewer objects than tasks: the grid has to find
+	// exactly the pairs brute force finds
+	for (size_t n : { 3, 5000 })
+	{
+		vector<unique_ptr<GameObject>> objects;
+		scatter(objects, n, n < 100 ? 2 : 150, rng);
+		vector<GameObject*> raw;
+		for (auto& o : objects) raw.push_back(o.get());
+		auto& pairs = broad_phase.find_pairs(raw.data(), raw.size(), pool);
+		cout << raw.size() << " objects: " << pairs.size() << " pairs from the grid, "
+			<< brute_force_pairs(raw) << " by brute force\n";
+	}
+
+	// a scene far wider than the grid, and an object without a position: the
+	// cells grow so the grid stays max_cells wide, and NaN never overlaps
+	{
+		vector<unique_ptr<GameObject>> objects;
+		scatter(objects, 5000, 150, rng);
+		objects[0]->x = -1e30f;
+		objects[1]->y = 1e30f;
+		objects[2]->x = NAN;
+		vector<GameObject*> raw;
+		for (auto& o : objects) raw.push_back(o.get());
+		auto& pairs = broad_phase.find_pairs(raw.data(), raw.size(), pool);
+		cout << "extreme positions: " << pairs.size() << " pairs from the grid, "
+			<< brute_force_pairs(raw) << " by brute force\n";
+	}
+
+	// a million objects drifting around for a few ticks
+	const size_t count = 1000000;
+	const float world = 2000;
+	vector<unique_ptr<GameObject>> objects;
+	scatter(objects, count, world, rng);
+	vector<GameObject*> raw;
+	for (auto& o : objects) raw.push_back(o.get());
+	uniform_real_distribution<float> step(-0.5f, 0.5f);
+
+	cout << count << " objects on " << pool.size() << " threads:\n";
+	for (int tick = 0; tick < 5; ++tick)
+	{
+		for (auto o : raw)
+		{
+			o->x = min(world, max(0.0f, o->x + step(rng)));
+			o->y = min(world, max(0.0f, o->y + step(rng)));
+		}
+
+		auto start = chrono::steady_clock::now();
+		auto& pairs = broad_phase.find_pairs(raw.data(), raw.size(), pool);
+		chrono::duration<double, milli> broad = chrono::steady_clock::now() - start;
+
+		fill(begin(outcome_counts), end(outcome_counts), 0);
+		start = chrono::steady_clock::now();
+		matrix.collide_all(pairs.data(), pairs.size());
+		chrono::duration<double, milli> dispatch = chrono::steady_clock::now() - start;
+
+		cout << "  tick " << tick << ": " << pairs.size() << " pairs (" << outcome_counts[1]
+			<< " asteroids burn up), broad phase " << broad.count() << " ms, dispatch "
+			<< dispatch.count() << " ms\n";
+	}
+	return 0;
+}
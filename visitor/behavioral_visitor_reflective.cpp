@@ -4,6 +4,8 @@
 #include <iostream>
 using namespace std;
 
+#include "behavioral_visitor_text_buffer.h"
+
 struct Expression
 {
   virtual ~Expression() = default;
@@ -63,6 +65,24 @@ struct ExpressionPrinter
   }
 
   string str() const { return oss.str(); }
+
+  // same output without the stream; `out` can be a reused growable buffer
+  // or a caller's fixed range
+  static void print(Expression *e, TextBuffer& out)
+  {
+    if (auto de = dynamic_cast<DoubleExpression*>(e))
+    {
+      out.put(de->value);
+    }
+    else if (auto ae = dynamic_cast<AdditionExpression*>(e))
+    {
+      out.put('(');
+      print(ae->left, out);
+      out.put('+');
+      print(ae->right, out);
+      out.put(')');
+    }
+  }
 };
 
 void main_3_()
@@ -79,4 +99,9 @@ void main_3_()
   ExpressionPrinter ep;
   ep.print(e);
   cout << ep.str() << endl;
+
+  char text[64];
+  TextBuffer out{ text, sizeof text };
+  ExpressionPrinter::print(e, out);
+  cout << out.str() << endl;
 }
\ No newline at end of file
@@ -0,0 +1,141 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+
+// output for printers that shouldn't allocate per call: either a growable
+// buffer that is reused between calls, or a caller's fixed char range.
+// a fixed buffer never overflows - it keeps the first capacity() bytes of
+// the output (like snprintf) and counts the rest, so size() is what the
+// full output needs, and a fixed buffer of capacity 0 is a measuring pass:
+//
+//   auto measure = TextBuffer::measuring();
+//   print(e, measure);
+//   TextBuffer out;
+//   out.reserve(measure.size());
+//   print(e, out); // no reallocation
+class TextBuffer
+{
+public:
+  TextBuffer() = default;
+  TextBuffer(char* data, size_t capacity) : data_{data}, capacity_{capacity}, growable{false} {}
+
+  static TextBuffer measuring() { return TextBuffer{nullptr, 0}; }
+
+  TextBuffer(const TextBuffer&) = delete;
+  TextBuffer& operator=(const TextBuffer&) = delete;
+
+  TextBuffer(TextBuffer&& other) { *this = std::move(other); }
+
+  TextBuffer& operator=(TextBuffer&& other)
+  {
+    owned = std::move(other.owned);
+    data_ = other.data_;
+    size_ = other.size_;
+    capacity_ = other.capacity_;
+    growable = other.growable;
+    other.data_ = nullptr;
+    other.size_ = other.capacity_ = 0;
+    return *this;
+  }
+
+  void put(char c)
+  {
+    if (size_ < capacity_ || make_room(1))
+      data_[size_] = c;
+    ++size_;
+  }
+
+  void put(const char* text, size_t length)
+  {
+    if (size_ + length <= capacity_ || make_room(length))
+      std::memcpy(data_ + size_, text, length);
+    else if (size_ < capacity_)
+      std::memcpy(data_ + size_, text, capacity_ - size_); // the part that fits
+    size_ += length;
+  }
+
+  // same text as `ostream << value` with the default format (%g, six
+  // significant digits). small integers, the common case, are converted
+  // here; anything else goes through snprintf into a local array
+  void put(double value)
+  {
+    if (value > -1e6 && value < 1e6 && !(value == 0 && std::signbit(value)))
+    {
+      auto integer = static_cast<int32_t>(value);
+      if (integer == value)
+      {
+        put_integer(integer);
+        return;
+      }
+    }
+    char text[32];
+    auto length = std::snprintf(text, sizeof text, "%g", value);
+    put(text, static_cast<size_t>(length));
+  }
+
+  // grows a growable buffer to at least `capacity`; no-op for fixed ones
+  void reserve(size_t capacity)
+  {
+    if (growable && capacity > capacity_)
+      reallocate(capacity);
+  }
+
+  // keeps the storage
+  void clear() { size_ = 0; }
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  size_t capacity() const { return capacity_; }
+
+  // only a fixed buffer can have dropped output
+  bool truncated() const { return size_ > capacity_; }
+
+  // the text actually stored: all of it, or the first capacity() bytes
+  std::string str() const { return std::string(data_, truncated() ? capacity_ : size_); }
+
+private:
+  void put_integer(int32_t value)
+  {
+    char digits[12];
+    auto end = digits + sizeof digits, p = end;
+    auto magnitude = value < 0 ? 0u - static_cast<uint32_t>(value) : static_cast<uint32_t>(value);
+    do
+    {
+      *--p = static_cast<char>('0' + magnitude % 10);
+      magnitude /= 10;
+    } while (magnitude);
+    if (value < 0)
+      *--p = '-';
+    put(p, static_cast<size_t>(end - p));
+  }
+
+  // false if the write has to be dropped
+  bool make_room(size_t length)
+  {
+    if (!growable)
+      return false;
+    reallocate(std::max(size_ + length, capacity_ * 2 + 64));
+    return true;
+  }
+
+  void reallocate(size_t capacity)
+  {
+    std::unique_ptr<char[]> bigger{new char[capacity]};
+    if (size_)
+      std::memcpy(bigger.get(), data_, size_);
+    owned = std::move(bigger);
+    data_ = owned.get();
+    capacity_ = capacity;
+  }
+
+  std::unique_ptr<char[]> owned;
+  char* data_ = nullptr;
+  size_t size_ = 0, capacity_ = 0;
+  bool growable = true;
+};
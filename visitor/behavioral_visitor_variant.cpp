@@ -0,0 +1,114 @@
+// closed, variant-based expression nodes in a pool, compared with the
+// usual heap-allocated polymorphic nodes
+#include <iostream>
+#include <random>
+#include <chrono>
+using namespace std;
+
+#include "behavioral_visitor_variant.h"
+
+namespace
+{
+  // the open-hierarchy baseline, as in the double dispatch example
+  struct HeapExpression
+  {
+    virtual ~HeapExpression() = default;
+    virtual double eval() const = 0;
+  };
+
+  struct HeapLiteral : HeapExpression
+  {
+    double value;
+    explicit HeapLiteral(double value) : value{value} {}
+    double eval() const override { return value; }
+  };
+
+  struct HeapBinary : HeapExpression
+  {
+    HeapExpression *left, *right;
+    bool subtract;
+
+    HeapBinary(HeapExpression* left, HeapExpression* right, bool subtract)
+      : left{left}, right{right}, subtract{subtract} {}
+
+    ~HeapBinary()
+    {
+      delete left;
+      delete right;
+    }
+
+    double eval() const override { return subtract ? left->eval() - right->eval() : left->eval() + right->eval(); }
+  };
+
+  // both builders consume the same random sequence, so both trees have
+  // the same shape and values
+  HeapExpression* heap_tree(size_t leaves, mt19937& rng)
+  {
+    if (leaves == 1)
+      return new HeapLiteral{ static_cast<double>(rng() % 10) };
+    auto left = 1 + rng() % (leaves - 1);
+    auto subtract = (rng() & 1) != 0;
+    auto l = heap_tree(left, rng);
+    return new HeapBinary{ l, heap_tree(leaves - left, rng), subtract };
+  }
+
+  NodeIndex pool_tree(size_t leaves, mt19937& rng, ExpressionPool& pool)
+  {
+    if (leaves == 1)
+      return pool.literal(static_cast<double>(rng() % 10));
+    auto left = 1 + rng() % (leaves - 1);
+    auto subtract = (rng() & 1) != 0;
+    auto l = pool_tree(left, rng, pool);
+    auto r = pool_tree(leaves - left, rng, pool);
+    return subtract ? pool.difference(l, r) : pool.sum(l, r);
+  }
+
+  double milliseconds_since(chrono::steady_clock::time_point start)
+  {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  }
+}
+
+int main_visitor_variant()
+{
+  ExpressionPool pool;
+  auto e = pool.sum(pool.literal(1), pool.difference(pool.literal(2), pool.literal(3)));
+  VariantPrinter{ pool, cout }(e);
+  cout << " = " << VariantEvaluator{ pool }(e) << "\n";
+  pool.clear();
+
+  const size_t leaves = 2000000;
+
+  mt19937 rng{ 3 };
+  auto start = chrono::steady_clock::now();
+  auto heap = heap_tree(leaves, rng);
+  auto heap_build = milliseconds_since(start);
+  start = chrono::steady_clock::now();
+  auto heap_result = heap->eval();
+  auto heap_eval = milliseconds_since(start);
+  start = chrono::steady_clock::now();
+  delete heap;
+  auto heap_free = milliseconds_since(start);
+
+  pool = ExpressionPool{ 2 * leaves };
+  rng.seed(3);
+  start = chrono::steady_clock::now();
+  auto root = pool_tree(leaves, rng, pool);
+  auto pool_build = milliseconds_since(start);
+  start = chrono::steady_clock::now();
+  auto pool_result = VariantEvaluator{ pool }(root);
+  auto pool_eval = milliseconds_since(start);
+  auto nodes = pool.size();
+  auto bytes = pool.bytes_used();
+  start = chrono::steady_clock::now();
+  pool.clear();
+  auto pool_free = milliseconds_since(start);
+
+  cout << nodes << " nodes, " << sizeof(ExpressionNode) << " bytes each, "
+    << bytes / 1e6 << " MB in the pool\n"
+    << "heap nodes:    build " << heap_build << " ms, eval " << heap_eval
+    << " ms, free " << heap_free << " ms = " << heap_result << "\n"
+    << "variant nodes: build " << pool_build << " ms, eval " << pool_eval
+    << " ms, free " << pool_free << " ms = " << pool_result << "\n";
+  return 0;
+}
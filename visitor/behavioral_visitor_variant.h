@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include <boost/variant.hpp>
+
+// closed expression hierarchy: the node kinds are the alternatives of one
+// variant and visitors are overload sets applied with apply_visitor, so
+// there are no vtables and no accept() methods. nodes refer to each other
+// by 32-bit index into an ExpressionPool instead of by pointer, which
+// halves the link size and lets a whole tree go away with one clear()
+
+using NodeIndex = uint32_t;
+
+struct Literal
+{
+  double value;
+};
+
+struct Sum
+{
+  NodeIndex left, right;
+};
+
+struct Difference
+{
+  NodeIndex left, right;
+};
+
+using ExpressionNode = boost::variant<Literal, Sum, Difference>;
+
+// append-only node storage; indices stay valid until clear()
+class ExpressionPool
+{
+public:
+  explicit ExpressionPool(size_t capacity = 0) { nodes.reserve(capacity); }
+
+  NodeIndex literal(double value) { return add(Literal{value}); }
+  NodeIndex sum(NodeIndex left, NodeIndex right) { return add(Sum{left, right}); }
+  NodeIndex difference(NodeIndex left, NodeIndex right) { return add(Difference{left, right}); }
+
+  const ExpressionNode& operator[](NodeIndex i) const { return nodes[i]; }
+  size_t size() const { return nodes.size(); }
+  size_t bytes_used() const { return nodes.size() * sizeof(ExpressionNode); }
+
+  // drops every node at once; keeps the storage for the next tree
+  void clear() { nodes.clear(); }
+
+private:
+  NodeIndex add(ExpressionNode node)
+  {
+    nodes.push_back(node);
+    return static_cast<NodeIndex>(nodes.size() - 1);
+  }
+
+  std::vector<ExpressionNode> nodes;
+};
+
+struct VariantEvaluator : boost::static_visitor<double>
+{
+  const ExpressionPool& pool;
+
+  explicit VariantEvaluator(const ExpressionPool& pool) : pool{pool} {}
+
+  double operator()(NodeIndex i) const { return boost::apply_visitor(*this, pool[i]); }
+
+  double operator()(const Literal& l) const { return l.value; }
+  double operator()(const Sum& s) const { return (*this)(s.left) + (*this)(s.right); }
+  double operator()(const Difference& d) const { return (*this)(d.left) - (*this)(d.right); }
+};
+
+struct VariantPrinter : boost::static_visitor<>
+{
+  const ExpressionPool& pool;
+  std::ostream& os;
+
+  VariantPrinter(const ExpressionPool& pool, std::ostream& os) : pool{pool}, os{os} {}
+
+  void operator()(NodeIndex i) const { boost::apply_visitor(*this, pool[i]); }
+
+  void operator()(const Literal& l) const { os << l.value; }
+  void operator()(const Sum& s) const { binary(s.left, '+', s.right); }
+  void operator()(const Difference& d) const { binary(d.left, '-', d.right); }
+
+private:
+  void binary(NodeIndex left, char op, NodeIndex right) const
+  {
+    os << "(";
+    (*this)(left);
+    os << op;
+    (*this)(right);
+    os << ")";
+  }
+};